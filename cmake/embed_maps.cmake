@@ -0,0 +1,37 @@
+# Writes a header defining the maps as string literals, one per row, parsed and checked at compile time by
+# src/embedded_map.h. Run by the build: cmake -DOUTPUT=embedded_maps.h -DMAPS=a.csv|b.csv -P embed_maps.cmake
+string( REPLACE "|" ";" MAPS "${MAPS}" )
+
+set( content "// Generated by cmake/embed_maps.cmake from the map files, don't edit\n#pragma once\n\n#include <array>\n#include \"embedded_map.h\"\n\nnamespace EmbeddedMaps {\n" )
+set( views "" )
+set( count 0 )
+
+foreach( path ${MAPS} )
+	get_filename_component( file_name ${path} NAME )
+	get_filename_component( identifier ${path} NAME_WE )
+	string( MAKE_C_IDENTIFIER ${identifier} identifier )
+
+	string( APPEND content "\tinline constexpr char ${identifier}Source[] =\n" )
+	file( STRINGS ${path} rows )
+	foreach( row ${rows} )
+		string( REPLACE "\r" "" row "${row}" )
+		string( REPLACE "\\" "\\\\" row "${row}" )
+		string( REPLACE "\"" "\\\"" row "${row}" )
+		string( APPEND content "\t\t\"${row}\\n\"\n" )
+	endforeach()
+	string( APPEND content "\t\t\"\";\n" )
+	string( APPEND content "\tinline constexpr Map<columns(${identifier}Source), rows(${identifier}Source)> ${identifier} = parse<columns(${identifier}Source), rows(${identifier}Source)>(${identifier}Source);\n\n" )
+
+	string( APPEND views "\t\tView(\"${file_name}\", ${identifier}),\n" )
+	math( EXPR count "${count} + 1" )
+endforeach()
+
+string( APPEND content "\tinline constexpr std::array<View, ${count}> all{ {\n${views}\t} };\n}\n" )
+
+# Left alone when nothing changed, so that the sources including it aren't rebuilt
+if (EXISTS ${OUTPUT})
+	file( READ ${OUTPUT} previous )
+endif ()
+if (NOT "${previous}" STREQUAL "${content}")
+	file( WRITE ${OUTPUT} "${content}" )
+endif ()
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <optional>
+#include <vector>
+#include "settings.h"
+#include "timer_wheel.h"
+
+enum ItemType {
+	Weapon0,
+	Weapon1,
+	Weapon2,
+	Weapon3,
+	Weapon4,
+	Weapon5,
+	Weapon6,
+	Weapon7,
+};
+
+struct Bounds {
+	glm::ivec2 position;
+	glm::ivec2 size;
+};
+
+class Actor {
+public:
+	Bounds bounds;
+
+	Actor(const Bounds& _bounds) : bounds(_bounds) {}
+};
+
+class Item : public Actor {
+public:
+	ItemType type;
+
+	Item(const Bounds& _bounds, const ItemType _type) : Actor(_bounds), type(_type) {}
+};
+
+struct Pathfinding {
+	struct TilePath {
+		int shortestPath;
+		glm::ivec2 backDirection;
+	};
+
+	std::vector< std::vector<TilePath> > tilePaths;
+	std::vector<glm::ivec2> queue;
+};
+
+// Where the commands of a drone come from
+enum class Controller {
+	Local, // Keyboard and gamepads of this machine
+	Bot,
+	Remote, // PlayerInput received over the network
+};
+
+struct PlayerInput {
+	glm::vec2 move{ 0, 0 };
+	glm::vec2 shoot{ 0, 0 };
+	bool fire = false;
+};
+
+class Player : public Actor {
+public:
+	int playerIndex;
+	Controller controller;
+	PlayerInput input; // Latest commands of a remote player
+	float health;
+	int score = 0;
+	int kills = 0; // Of other drones, the score without the suicides
+	bool weaponReady = true;
+	std::optional<WeaponType> weapon;
+	int ammo = 0;
+	glm::vec2 subpixelPosition;
+	glm::ivec2 previousPosition; // At the start of the last tick, for interpolated rendering
+	Pathfinding pathfinding;
+	glm::ivec2 flankDirection{ 0, 0 }; // Bots, the direction kept while flanking
+	int flankTicks = 0; // Bots, ticks left before the flank is chosen again
+
+	Player(const Bounds& _bounds, const int player_index, const Controller _controller, const float _health) : Actor(_bounds), playerIndex(player_index), controller(_controller), health(_health), subpixelPosition(bounds.position), previousPosition(bounds.position) { }
+};
+
+class Projectile : public Actor {
+public:
+	Projectile(const Bounds& _bounds, const int owner_player_index, const int from_weapon, const glm::vec2& subpixel_velocity) :
+		Actor(_bounds), ownerPlayerIndex(owner_player_index), fromWeapon(from_weapon), previousPosition(_bounds.position), subpixelVelocity(subpixel_velocity) {
+		subpixelPosition = glm::vec2(bounds.position) + glm::vec2(bounds.size) * 0.5f;
+	}
+
+	int ownerPlayerIndex;
+	int fromWeapon;
+	TimerHandle expiryTimer;
+	glm::ivec2 previousPosition; // At the start of the last tick, for interpolated rendering
+	glm::vec2 subpixelPosition;
+	glm::vec2 subpixelVelocity;
+};
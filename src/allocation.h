@@ -0,0 +1,291 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Counts the heap allocations of the whole program. The replacement operator new/delete are only compiled in
+// the translation unit that defines DD_ALLOCATION_HOOK_IMPLEMENTATION, before including this file.
+struct AllocationCounter {
+	struct Snapshot {
+		uint64_t allocations;
+		uint64_t bytes;
+	};
+
+	static std::atomic<uint64_t>& allocations() {
+		static std::atomic<uint64_t> counter{ 0 };
+		return counter;
+	}
+
+	static std::atomic<uint64_t>& bytes() {
+		static std::atomic<uint64_t> counter{ 0 };
+		return counter;
+	}
+
+	static Snapshot snapshot() {
+		return Snapshot{ allocations().load(std::memory_order_relaxed), bytes().load(std::memory_order_relaxed) };
+	}
+
+	static void count(const size_t size) {
+		allocations().fetch_add(1, std::memory_order_relaxed);
+		bytes().fetch_add(size, std::memory_order_relaxed);
+	}
+};
+
+#ifdef DD_ALLOCATION_HOOK_IMPLEMENTATION
+void* operator new(std::size_t size) {
+	AllocationCounter::count(size);
+	if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	AllocationCounter::count(size);
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+#endif
+
+// Fixed size blocks for node based containers, carved from chunks that are kept until the pool is destroyed.
+// Blocks of every size requested are kept in separate free lists, since containers rebind to their node types.
+class NodePool {
+public:
+	NodePool(const size_t _blocksPerChunk) : blocksPerChunk(_blocksPerChunk) {
+	}
+
+	NodePool(const NodePool&) = delete;
+	NodePool& operator=(const NodePool&) = delete;
+
+	~NodePool() {
+		for (void* chunk : chunks) {
+			::operator delete(chunk);
+		}
+	}
+
+	void* allocate(const size_t size) {
+		FreeList& free_list = freeList(size);
+		if (free_list.head == nullptr) {
+			grow(free_list);
+		}
+
+		Block* block = free_list.head;
+		free_list.head = block->next;
+		return block;
+	}
+
+	void deallocate(void* memory, const size_t size) {
+		FreeList& free_list = freeList(size);
+		Block* block = static_cast<Block*>(memory);
+		block->next = free_list.head;
+		free_list.head = block;
+	}
+
+private:
+	struct Block {
+		Block* next;
+	};
+
+	struct FreeList {
+		size_t blockSize;
+		Block* head;
+	};
+
+	static constexpr size_t maxBlockSizes = 4;
+
+	size_t blocksPerChunk;
+	std::array<FreeList, maxBlockSizes> freeLists{};
+	size_t blockSizes = 0;
+	std::vector<void*> chunks;
+
+	static size_t roundedSize(const size_t size) {
+		const size_t alignment = alignof(std::max_align_t);
+		return std::max((size + alignment - 1) / alignment * alignment, sizeof(Block));
+	}
+
+	FreeList& freeList(const size_t size) {
+		const size_t block_size = roundedSize(size);
+		for (size_t i = 0; i < blockSizes; ++i) {
+			if (freeLists[i].blockSize == block_size) {
+				return freeLists[i];
+			}
+		}
+
+		if (blockSizes == maxBlockSizes) {
+			throw std::bad_alloc();
+		}
+
+		freeLists[blockSizes] = FreeList{ block_size, nullptr };
+		return freeLists[blockSizes++];
+	}
+
+	void grow(FreeList& free_list) {
+		char* chunk = static_cast<char*>(::operator new(free_list.blockSize * blocksPerChunk));
+		chunks.push_back(chunk);
+
+		for (size_t i = blocksPerChunk; i-- > 0;) {
+			Block* block = reinterpret_cast<Block*>(chunk + i * free_list.blockSize);
+			block->next = free_list.head;
+			free_list.head = block;
+		}
+	}
+};
+
+template<typename T>
+class PoolAllocator;
+
+template<typename T>
+using PooledList = std::list<T, PoolAllocator<T>>;
+
+template<typename T>
+class PoolAllocator {
+public:
+	using value_type = T;
+
+	NodePool* pool;
+
+	PoolAllocator(NodePool& _pool) : pool(&_pool) {
+	}
+
+	template<typename U>
+	PoolAllocator(const PoolAllocator<U>& other) : pool(other.pool) {
+	}
+
+	T* allocate(const size_t count) {
+		if (count != 1) {
+			return static_cast<T*>(::operator new(count * sizeof(T)));
+		}
+		return static_cast<T*>(pool->allocate(sizeof(T)));
+	}
+
+	void deallocate(T* memory, const size_t count) {
+		if (count != 1) {
+			::operator delete(memory);
+			return;
+		}
+		pool->deallocate(memory, sizeof(T));
+	}
+
+	template<typename U>
+	bool operator==(const PoolAllocator<U>& other) const {
+		return pool == other.pool;
+	}
+
+	template<typename U>
+	bool operator!=(const PoolAllocator<U>& other) const {
+		return pool != other.pool;
+	}
+};
+
+// Bump allocator for scratch memory that lives until the next reset, usually the next tick.
+// Requests that don't fit fall back to the heap, and grow the buffer at the following reset.
+class FrameArena {
+public:
+	FrameArena(const size_t capacity) : buffer(capacity) {
+	}
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	~FrameArena() {
+		releaseOverflow();
+	}
+
+	void reset() {
+		if (!overflow.empty()) {
+			releaseOverflow();
+			buffer.resize(buffer.size() * 2);
+		}
+		used = 0;
+	}
+
+	void* allocate(const size_t size, const size_t alignment) {
+		const size_t start = (used + alignment - 1) / alignment * alignment;
+		if (start + size > buffer.size()) {
+			void* memory = ::operator new(size);
+			overflow.push_back(memory);
+			return memory;
+		}
+
+		used = start + size;
+		return buffer.data() + start;
+	}
+
+private:
+	std::vector<unsigned char> buffer;
+	size_t used = 0;
+	std::vector<void*> overflow;
+
+	void releaseOverflow() {
+		for (void* memory : overflow) {
+			::operator delete(memory);
+		}
+		overflow.clear();
+	}
+};
+
+template<typename T>
+class ArenaAllocator {
+public:
+	using value_type = T;
+
+	FrameArena* arena;
+
+	ArenaAllocator(FrameArena& _arena) : arena(&_arena) {
+	}
+
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {
+	}
+
+	T* allocate(const size_t count) {
+		return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, const size_t) {
+	}
+
+	template<typename U>
+	bool operator==(const ArenaAllocator<U>& other) const {
+		return arena == other.arena;
+	}
+
+	template<typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const {
+		return arena != other.arena;
+	}
+};
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <raylib.h>
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <vector>
+#include "content.h"
+#include "session.h"
+
+// Plays the sound events emitted by a session tick. Events for the same sound are counted, the most important sounds
+// are played first, and each one gets as many voices as it had events, up to the size of its voice pool and as long
+// as the global voice cap allows it.
+class AudioStage {
+public:
+	static constexpr int maxVoices = 8;
+	static constexpr size_t maxEventsPerTick = 16;
+
+	Content& content;
+
+	AudioStage(Content& _content) : content(_content) {
+	}
+
+	void play(const std::vector<Session::SoundEvent>& events) {
+		std::array<SoundRequest, maxEventsPerTick> requests;
+		size_t request_count = 0;
+
+		for (const Session::SoundEvent& event : events) {
+			const auto end = requests.begin() + request_count;
+			const auto same_sound = std::find_if(requests.begin(), end, [&event](const SoundRequest& request) {
+				return request.event.type == event.type && request.event.soundIndex == event.soundIndex;
+			});
+
+			if (same_sound != end) {
+				same_sound->count += 1;
+			}
+			else if (request_count < requests.size()) {
+				requests.at(request_count++) = SoundRequest{ event, 1 };
+			}
+		}
+
+		std::sort(requests.begin(), requests.begin() + request_count, [](const SoundRequest& request0, const SoundRequest& request1) {
+			return priority(request0.event) > priority(request1.event);
+		});
+
+		int playing_voices = countPlayingVoices(content.reloadSound);
+		for (const SoundVoices& sound : content.weaponSounds) {
+			playing_voices += countPlayingVoices(sound);
+		}
+
+		for (size_t i = 0; i < request_count && playing_voices < maxVoices; ++i) {
+			SoundVoices& sound = voices(requests.at(i).event);
+			const int count = std::min(requests.at(i).count, int(sound.voices.size()));
+			for (int j = 0; j < count && playing_voices < maxVoices; ++j) {
+				if (playVoice(sound)) {
+					++playing_voices;
+				}
+			}
+		}
+	}
+
+private:
+	struct SoundRequest {
+		Session::SoundEvent event;
+		int count;
+	};
+
+	// Of the weapon sounds by soundIndex: shot.mp3, then rocket.mp3. Rockets go before shots, and both before reloads.
+	static constexpr std::array<int, std::tuple_size<decltype(Content::weaponSounds)>::value> weaponSoundPriorities{ 1, 2 };
+	static constexpr int reloadPriority = 0;
+
+	static int priority(const Session::SoundEvent& event) {
+		return event.type == Session::SoundEvent::Weapon ? weaponSoundPriorities.at(event.soundIndex) : reloadPriority;
+	}
+
+	SoundVoices& voices(const Session::SoundEvent& event) {
+		return event.type == Session::SoundEvent::Weapon ? content.weaponSounds.at(event.soundIndex) : content.reloadSound;
+	}
+
+	static int countPlayingVoices(const SoundVoices& sound) {
+		int playing = 0;
+		for (const Sound& voice : sound.voices) {
+			playing += IsSoundPlaying(voice) ? 1 : 0;
+		}
+		return playing;
+	}
+
+	// Uses an idle voice if there is one, otherwise restarts the one that was started longest ago.
+	// Returns true if a new voice was started, false if one was restarted.
+	static bool playVoice(SoundVoices& sound) {
+		if (sound.voices.empty()) {
+			return false;
+		}
+
+		for (size_t i = 0; i < sound.voices.size(); ++i) {
+			const size_t index = (sound.nextVoice + i) % sound.voices.size();
+			if (!IsSoundPlaying(sound.voices.at(index))) {
+				PlaySound(sound.voices.at(index));
+				sound.nextVoice = (index + 1) % sound.voices.size();
+				return true;
+			}
+		}
+
+		PlaySound(sound.voices.at(sound.nextVoice));
+		sound.nextVoice = (sound.nextVoice + 1) % sound.voices.size();
+		return false;
+	}
+};
@@ -0,0 +1,506 @@
+#define DD_ALLOCATION_HOOK_IMPLEMENTATION
+#include "allocation.h"
+
+#include <raylib.h>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include "settings.h"
+#include "level.h"
+#include "session.h"
+#include "visibility.h"
+#include "embedded_maps.h"
+#include "generator.h"
+#include "particles.h"
+#include "benchmark.h"
+
+// Plays bot matches the way the game does, a frame of one tick at a time through advance(), and returns the heap
+// allocations made by the ticks after the warmup. A finished match is restarted like scenarios.cpp does, outside of
+// the count: the rankings and the restart are between matches, not ticks.
+uint64_t countTickAllocations(const Settings& settings, const Level& level, Telemetry& telemetry, const int bots, const int warmup_ticks, const int ticks) {
+	Session session(settings, level, 1234);
+	session.telemetry = &telemetry;
+	for (int i = 0; i < bots; ++i) {
+		session.addPlayer(i, Controller::Bot);
+	}
+
+	const float frame_time = 1.0f / settings.tickRate;
+	uint64_t allocations = 0;
+	uint64_t bytes = 0;
+	int counted_ticks = 0;
+	int matches = 1;
+	for (int tick = 0; tick < warmup_ticks + ticks;) {
+		const AllocationCounter::Snapshot start = AllocationCounter::snapshot();
+		const int advanced = session.advance(frame_time);
+		const AllocationCounter::Snapshot end = AllocationCounter::snapshot();
+
+		if (tick >= warmup_ticks) {
+			allocations += end.allocations - start.allocations;
+			bytes += end.bytes - start.bytes;
+			counted_ticks += advanced;
+		}
+		tick += advanced;
+
+		if (session.checkEndgame().has_value()) {
+			session.restart(level);
+			++matches;
+		}
+	}
+
+	printf("%-40s %12.3f allocations/tick %12.1f bytes/tick %6d matches\n", ("allocations (" + std::to_string(bots) + " bots)").c_str(),
+		double(allocations) / std::max(counted_ticks, 1), double(bytes) / std::max(counted_ticks, 1), matches);
+	return allocations;
+}
+
+// Symmetric shadowcasting one tile at a time, with exact fractions, the reference for the bit scans of Visibility
+class ReferenceShadowcaster {
+public:
+	ReferenceShadowcaster(const Level& level) : width(level.width), height(level.height), walls(size_t(level.width) * level.height), lit(walls.size()) {
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				walls[size_t(y) * width + x] = level.tile(x, y).solidity > 0;
+			}
+		}
+	}
+
+	const std::vector<uint8_t>& update(const glm::ivec2& origin) {
+		std::fill(lit.begin(), lit.end(), 0);
+		lit[size_t(origin.y) * width + origin.x] = 1;
+		for (int quadrant = 0; quadrant < 4; ++quadrant) {
+			scan(quadrant, origin, 1, -1, 1, 1, 1);
+		}
+		return lit;
+	}
+
+private:
+	int width;
+	int height;
+	std::vector<uint8_t> walls;
+	std::vector<uint8_t> lit;
+
+	static int64_t floorDivide(const int64_t num, const int64_t den) {
+		return num / den - ((num % den != 0) && ((num < 0) != (den < 0)));
+	}
+
+	// North, south, east and west
+	glm::ivec2 tile(const int quadrant, const glm::ivec2& origin, const int depth, const int column) const {
+		switch (quadrant) {
+		case 0: return origin + glm::ivec2(column, -depth);
+		case 1: return origin + glm::ivec2(column, depth);
+		case 2: return origin + glm::ivec2(depth, column);
+		default: return origin + glm::ivec2(-depth, column);
+		}
+	}
+
+	// Slopes are start_num / start_den and end_num / end_den
+	void scan(const int quadrant, const glm::ivec2& origin, const int depth, int64_t start_num, int64_t start_den, const int64_t end_num, const int64_t end_den) {
+		const int64_t column_min = floorDivide(2 * depth * start_num + start_den, 2 * start_den);
+		const int64_t column_max = -floorDivide(-(2 * depth * end_num - end_den), 2 * end_den);
+
+		int previous = -1; // Wall, floor, or nothing yet
+		for (int64_t column = column_min; column <= column_max; ++column) {
+			const glm::ivec2 position = tile(quadrant, origin, depth, int(column));
+			if (position.x < 0 || position.y < 0 || position.x >= width || position.y >= height) {
+				continue;
+			}
+
+			const int wall = walls[size_t(position.y) * width + position.x];
+			const bool symmetric = column * start_den >= depth * start_num && column * end_den <= depth * end_num;
+			if (wall || symmetric) {
+				lit[size_t(position.y) * width + position.x] = 1;
+			}
+			if (previous == 1 && wall == 0) {
+				start_num = 2 * column - 1;
+				start_den = 2 * depth;
+			}
+			if (previous == 0 && wall == 1) {
+				scan(quadrant, origin, depth + 1, start_num, start_den, 2 * column - 1, 2 * depth);
+			}
+			previous = wall;
+		}
+
+		if (previous == 0) {
+			scan(quadrant, origin, depth + 1, start_num, start_den, end_num, end_den);
+		}
+	}
+};
+
+// Compares the views of Visibility with the reference on random levels, widths and heights on either side of the
+// 64 bit words and open maps included, then after destroying walls. Returns the number of tiles that differ.
+uint64_t checkVisibility(const Settings& settings) {
+	std::mt19937 random_generator(1234);
+	uint64_t mismatches = 0;
+
+	for (int level_index = 0; level_index < 300; ++level_index) {
+		const bool word_multiple = level_index % 3 == 0;
+		const int width = word_multiple ? 64 * int(1 + random_generator() % 3) : int(20 + random_generator() % 100);
+		const int height = word_multiple ? 64 * int(1 + random_generator() % 3) : int(20 + random_generator() % 100);
+		const uint32_t wall_permille = level_index % 6 == 0 ? 0 : uint32_t(random_generator() % 50) * 10;
+
+		Level level(settings, width, height);
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				level.tile(x, y) = Level::Tile{ false, random_generator() % 1000 < wall_permille ? settings.tileHealth : 0.0f };
+			}
+		}
+
+		Visibility visibility(level);
+		ReferenceShadowcaster reference(level);
+		for (int origin_index = 0; origin_index < 6; ++origin_index) {
+			// The last origin is after destroying walls, some of them seen
+			if (origin_index == 5) {
+				std::vector<glm::ivec2> destroyed_tiles;
+				for (int i = 0; i < 20; ++i) {
+					const glm::ivec2 tile(int(random_generator() % width), int(random_generator() % height));
+					if (level.tile(tile.x, tile.y).solidity > 0) {
+						level.tile(tile.x, tile.y).solidity = 0;
+						destroyed_tiles.push_back(tile);
+					}
+				}
+				visibility.destroyTiles(level, destroyed_tiles, 0);
+				reference = ReferenceShadowcaster(level);
+			}
+
+			const glm::ivec2 origin(int(random_generator() % width), int(random_generator() % height));
+			visibility.update(0, origin);
+			const std::vector<uint8_t>& lit = reference.update(origin);
+			for (int y = 0; y < height; ++y) {
+				for (int x = 0; x < width; ++x) {
+					mismatches += visibility.visible(0, glm::ivec2(x, y)) != bool(lit[size_t(y) * width + x]);
+				}
+			}
+		}
+	}
+
+	printf("%-40s %12llu mismatched tiles\n", "visibility (300 levels)", (unsigned long long)mismatches);
+	return mismatches;
+}
+
+// Microbenchmarks of the simulation kernels. Runs without a window or audio device, from the directory containing the game data:
+// destructive_drones_bench [--map map0.csv] [--warmup N] [--repetitions N] [--filter substring] [--json output.json] [--check-allocations] [--check-visibility]
+int main(int argc, char** argv) {
+	std::string map_path = "map0.csv";
+	std::string json_path;
+	std::string filter;
+	int warmup = 10;
+	int repetitions = 100;
+	bool check_allocations = false;
+	bool check_visibility = false;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		const bool has_value = i + 1 < argc;
+
+		if (arg == "--map" && has_value) {
+			map_path = argv[++i];
+		}
+		else if (arg == "--json" && has_value) {
+			json_path = argv[++i];
+		}
+		else if (arg == "--filter" && has_value) {
+			filter = argv[++i];
+		}
+		else if (arg == "--warmup" && has_value) {
+			warmup = std::atoi(argv[++i]);
+		}
+		else if (arg == "--repetitions" && has_value) {
+			repetitions = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (arg == "--check-allocations") {
+			check_allocations = true;
+		}
+		else if (arg == "--check-visibility") {
+			check_visibility = true;
+		}
+		else {
+			printf("Usage: %s [--map path] [--warmup N] [--repetitions N] [--filter substring] [--json path] [--check-allocations] [--check-visibility]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	SetTraceLogLevel(LOG_WARNING);
+
+	const Settings settings;
+	Level level(settings, map_path);
+	if (level.playerSpawns.empty()) {
+		printf("Couldn't load %s\n", map_path.c_str());
+		return 1;
+	}
+
+	const int max_bots = int(std::min(level.playerSpawns.size(), settings.playerTints.size()));
+
+	if (check_visibility) {
+		return checkVisibility(settings) == 0 ? 0 : 1;
+	}
+
+	if (check_allocations) {
+		// Steady state ticks must not touch the heap, with telemetry recording too, and with the fog of war
+		Telemetry telemetry(std::filesystem::temp_directory_path() / "destructive_drones_bench.ddtl");
+		uint64_t allocations = 0;
+		for (int bots = 1; bots <= max_bots; ++bots) {
+			allocations += countTickAllocations(settings, level, telemetry, bots, int(settings.tickRate) * 60, int(settings.tickRate) * 60);
+		}
+
+		Settings fog_settings = settings;
+		fog_settings.fogOfWar = true;
+		allocations += countTickAllocations(fog_settings, level, telemetry, max_bots, int(settings.tickRate) * 60, int(settings.tickRate) * 60);
+		return allocations == 0 ? 0 : 1;
+	}
+
+	Benchmark benchmark(warmup, repetitions, filter);
+	benchmark.printHeader();
+
+	const int batch_size = 1024;
+	std::mt19937 random_generator(1234);
+	std::uniform_int_distribution<int> random_x(0, level.width - 1);
+	std::uniform_int_distribution<int> random_y(0, level.height - 1);
+	std::uniform_int_distribution<int> random_size(1, 8);
+
+	std::vector<Bounds> random_bounds;
+	std::vector<glm::ivec2> random_points;
+	for (int i = 0; i < batch_size; ++i) {
+		random_bounds.push_back(Bounds{ glm::ivec2(random_x(random_generator), random_y(random_generator)), glm::ivec2(random_size(random_generator), random_size(random_generator)) });
+		random_points.push_back(glm::ivec2(random_x(random_generator), random_y(random_generator)));
+	}
+
+	benchmark.run("collide(bounds, bounds) x1024", 10, [&]() {
+		int hits = 0;
+		for (int i = 0; i < batch_size; ++i) {
+			hits += Session::collide(random_bounds.at(i), random_bounds.at(batch_size - 1 - i));
+		}
+		doNotOptimize(hits);
+	});
+
+	benchmark.run("collide(bounds, level) x1024", 10, [&]() {
+		int hits = 0;
+		for (int i = 0; i < batch_size; ++i) {
+			hits += Session::collide(random_bounds.at(i), level);
+		}
+		doNotOptimize(hits);
+	});
+
+	benchmark.run("collide(point, bounds) x1024", 10, [&]() {
+		int hits = 0;
+		for (int i = 0; i < batch_size; ++i) {
+			hits += Session::collide(random_points.at(i), random_bounds.at(i));
+		}
+		doNotOptimize(hits);
+	});
+
+	benchmark.run("collide(point, level) x1024", 10, [&]() {
+		int hits = 0;
+		for (int i = 0; i < batch_size; ++i) {
+			hits += Session::collide(random_points.at(i), level);
+		}
+		doNotOptimize(hits);
+	});
+
+	std::vector<glm::ivec2> line;
+	benchmark.run("rasterizeLine x1024", 1, [&]() {
+		size_t pixels = 0;
+		for (int i = 0; i < batch_size; ++i) {
+			Session::rasterizeLine(random_points.at(i), random_points.at(batch_size - 1 - i), line);
+			pixels += line.size();
+		}
+		doNotOptimize(pixels);
+	});
+
+	benchmark.run("Level::loadLevel", 1, [&]() {
+		level.loadLevel(map_path);
+		doNotOptimize(level.tiles);
+	});
+
+	Level::Pixels pixels;
+	benchmark.run("Level::buildPixels", 10, [&]() {
+		level.buildPixels(pixels);
+		doNotOptimize(pixels);
+	});
+
+	{
+		LevelGenerator::Options options;
+		options.width = 1024;
+		options.height = 1024;
+		Level generated(settings, options.width, options.height);
+
+		std::mt19937_64 bits_generator(1234);
+		std::vector<BitGrid> grids(2, BitGrid(options.width, options.height, true));
+		for (uint64_t& word : grids.front().bits) {
+			word = LevelGenerator::randomBits(bits_generator, options.wallRatio);
+		}
+
+		benchmark.run("LevelGenerator::smooth 1024x1024", 1, [&]() {
+			LevelGenerator::smooth(grids.at(0), grids.at(1));
+			doNotOptimize(grids.at(1).bits);
+		});
+
+		for (const LevelGenerator::Layout layout : { LevelGenerator::Layout::Caves, LevelGenerator::Layout::Rooms, LevelGenerator::Layout::Arena }) {
+			static const std::array<const char*, 3> names{ "caves", "rooms", "arena" };
+			options.layout = layout;
+			benchmark.run(std::string("LevelGenerator::generate ") + names.at(int(layout)) + " 1024x1024", 1, [&]() {
+				LevelGenerator::generate(options, generated);
+				++options.seed;
+				doNotOptimize(generated.tiles);
+			});
+		}
+
+		// A drone going back and forth between two tiles of the last arena, each move recomputes the view
+		if (!generated.playerSpawns.empty()) {
+			Visibility visibility(generated);
+			const glm::ivec2 spawn = generated.playerSpawns.front() + glm::ivec2(1, 2);
+			int moves = 0;
+			benchmark.run("Visibility::update 1024x1024 (moving)", 10, [&]() {
+				visibility.update(0, spawn + glm::ivec2(moves++ & 1, 0));
+				doNotOptimize(visibility.view(0).bits);
+			});
+		}
+	}
+
+	{
+		Session session(settings, level);
+		session.addPlayer(0, Controller::Bot);
+
+		benchmark.run("Session::updatePathfinding", 10, [&]() {
+			Session::updatePathfinding(session.players.front(), session.level);
+			doNotOptimize(session.players.front().pathfinding);
+		});
+
+		const glm::ivec2 center(level.width / 2, level.height / 2);
+		const Projectile bullet(Bounds{ center, glm::ivec2(1, 1) }, 0, WeaponType::MachineGun, glm::vec2(0, 0));
+		const Projectile rocket(Bounds{ center, glm::ivec2(1, 1) }, 0, WeaponType::RocketLauncher, glm::vec2(0, 0));
+
+		benchmark.run("Session::applyHit (machine gun)", 100, [&]() {
+			session.applyHit<WeaponType::MachineGun>(bullet, center);
+			doNotOptimize(session.level.tiles);
+		});
+
+		benchmark.run("Session::applyHit (rocket)", 100, [&]() {
+			session.applyHit<WeaponType::RocketLauncher>(rocket, center);
+			doNotOptimize(session.level.tiles);
+		});
+
+		// The crater of the hits above, once whatever it cut off has fallen: the usual case of every neighbor still standing
+		std::vector<glm::ivec2> crater;
+		const int radius = settings.weapons.at(WeaponType::RocketLauncher).blastRadius;
+		for (int y = center.y - radius; y <= center.y + radius; ++y) {
+			for (int x = center.x - radius; x <= center.x + radius; ++x) {
+				if (Session::inLevel(glm::ivec2(x, y), session.level) && !session.level.tile(x, y).bedrock && session.level.tile(x, y).solidity <= 0) {
+					crater.push_back(glm::ivec2(x, y));
+				}
+			}
+		}
+		session.integrity.collapse(session.level, crater, 0);
+
+		const size_t crater_size = crater.size();
+		benchmark.run("StructuralIntegrity::collapse (rocket crater)", 100, [&]() {
+			session.integrity.collapse(session.level, crater, 0);
+			crater.resize(crater_size);
+			doNotOptimize(crater);
+		});
+	}
+
+	{
+		// Enough destroyed tiles to fill the pool
+		std::vector<glm::ivec2> destroyed_tiles;
+		for (size_t i = 0; i < DebrisParticles::capacity / settings.debrisPerTile; ++i) {
+			destroyed_tiles.push_back(glm::ivec2(random_x(random_generator), random_y(random_generator)));
+		}
+
+		DebrisParticles debris(settings, level.width, level.height);
+		benchmark.run("DebrisParticles::update (full pool)", 10, [&]() {
+			if (debris.size() < DebrisParticles::capacity / 2) {
+				debris.spawn(destroyed_tiles);
+			}
+			debris.update(1.0f / 600.0f);
+			doNotOptimize(debris);
+		});
+
+		benchmark.run("DebrisParticles::splat (full pool)", 10, [&]() {
+			debris.splat();
+			doNotOptimize(debris);
+		});
+	}
+
+	for (int bots = 1; bots <= max_bots; ++bots) {
+		Session session(settings, level);
+		for (int i = 0; i < bots; ++i) {
+			session.addPlayer(i, Controller::Bot);
+		}
+
+		const std::string name = "Session::update (" + std::to_string(bots) + " bots)";
+		const size_t results = benchmark.results.size();
+		benchmark.run(name, 10, [&]() {
+			session.update(1.0f / settings.tickRate);
+		});
+
+		if (benchmark.results.size() > results) {
+			printf("%-40s %12.0f ticks/s\n", name.c_str(), 1e9 / benchmark.results.back().mean);
+		}
+	}
+
+	{
+		// Rematch, against loading and parsing the level again
+		Session session(settings, level, 1234);
+		for (int i = 0; i < max_bots; ++i) {
+			session.addPlayer(i, Controller::Bot);
+		}
+		for (int i = 0; i < int(settings.tickRate) * 60; ++i) {
+			session.update(1.0f / settings.tickRate);
+		}
+
+		benchmark.run("Session::restart (" + std::to_string(max_bots) + " bots)", 1, [&]() {
+			session.restart(level);
+			doNotOptimize(session);
+		});
+
+		benchmark.run("Level (parse " + map_path + ")", 1, [&]() {
+			Level parsed(settings, map_path);
+			doNotOptimize(parsed);
+		});
+
+		for (const EmbeddedMaps::View& map : EmbeddedMaps::all) {
+			benchmark.run(std::string("Level (built-in ") + map.name + ")", 1, [&]() {
+				Level built_in(settings, map);
+				doNotOptimize(built_in);
+			});
+		}
+	}
+
+	{
+		// Same match twice, to compare the cost of recording telemetry
+		Telemetry telemetry(std::filesystem::temp_directory_path() / "destructive_drones_bench.ddtl");
+		for (const bool record : { false, true }) {
+			Session session(settings, level, 1234);
+			session.telemetry = record ? &telemetry : nullptr;
+			for (int i = 0; i < max_bots; ++i) {
+				session.addPlayer(i, Controller::Bot);
+			}
+
+			benchmark.run(std::string("Session::update (") + std::to_string(max_bots) + " bots, telemetry " + (record ? "on)" : "off)"), 10, [&]() {
+				session.update(1.0f / settings.tickRate);
+			});
+		}
+	}
+
+	{
+		Settings fog_settings = settings;
+		fog_settings.fogOfWar = true;
+		Session session(fog_settings, level, 1234);
+		for (int i = 0; i < max_bots; ++i) {
+			session.addPlayer(i, Controller::Bot);
+		}
+
+		benchmark.run("Session::update (" + std::to_string(max_bots) + " bots, fog of war)", 10, [&]() {
+			session.update(1.0f / settings.tickRate);
+		});
+	}
+
+	if (!json_path.empty() && !benchmark.writeJson(json_path)) {
+		printf("Couldn't write %s\n", json_path.c_str());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from optimizing away a value computed by a benchmark
+template<typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void* sink;
+	sink = &value;
+#endif
+}
+
+class Benchmark {
+public:
+	struct Result {
+		std::string name;
+		int iterations;
+		int repetitions;
+		double mean;
+		double min;
+		double p50;
+		double p90;
+		double p99;
+		double max;
+	};
+
+	int warmup;
+	int repetitions;
+	std::string filter;
+	std::vector<Result> results;
+
+	// At least one repetition, the statistics need a sample
+	Benchmark(const int _warmup, const int _repetitions, const std::string& _filter) : warmup(_warmup), repetitions(std::max(_repetitions, 1)), filter(_filter) {
+	}
+
+	// Times `iterations` calls of the function per repetition, and reports nanoseconds per call
+	void run(const std::string& name, const int iterations, const std::function<void()>& function) {
+		if (!filter.empty() && name.find(filter) == std::string::npos) {
+			return;
+		}
+
+		for (int i = 0; i < warmup; ++i) {
+			for (int j = 0; j < iterations; ++j) {
+				function();
+			}
+		}
+
+		std::vector<double> samples;
+		samples.reserve(repetitions);
+
+		for (int i = 0; i < repetitions; ++i) {
+			const auto start = std::chrono::steady_clock::now();
+			for (int j = 0; j < iterations; ++j) {
+				function();
+			}
+			const auto end = std::chrono::steady_clock::now();
+
+			samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / iterations);
+		}
+
+		std::sort(samples.begin(), samples.end());
+
+		Result result;
+		result.name = name;
+		result.iterations = iterations;
+		result.repetitions = repetitions;
+		result.mean = 0;
+		for (double sample : samples) {
+			result.mean += sample;
+		}
+		result.mean /= samples.size();
+		result.min = samples.front();
+		result.p50 = percentile(samples, 0.50);
+		result.p90 = percentile(samples, 0.90);
+		result.p99 = percentile(samples, 0.99);
+		result.max = samples.back();
+
+		printf("%-40s %12.1f %12.1f %12.1f %12.1f ns\n", result.name.c_str(), result.p50, result.p90, result.p99, result.mean);
+		results.emplace_back(std::move(result));
+	}
+
+	void printHeader() const {
+		printf("%-40s %12s %12s %12s %12s\n", "benchmark", "p50", "p90", "p99", "mean");
+	}
+
+	bool writeJson(const std::string& path) const {
+		FILE* file = fopen(path.c_str(), "w");
+		if (file == nullptr) {
+			return false;
+		}
+
+		fprintf(file, "{\n\t\"unit\": \"ns\",\n\t\"warmup\": %d,\n\t\"repetitions\": %d,\n\t\"benchmarks\": [\n", warmup, repetitions);
+		for (size_t i = 0; i < results.size(); ++i) {
+			const Result& result = results.at(i);
+			fprintf(file, "\t\t{ \"name\": \"%s\", \"iterations\": %d, \"mean\": %.1f, \"min\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f }%s\n",
+				result.name.c_str(), result.iterations, result.mean, result.min, result.p50, result.p90, result.p99, result.max, i + 1 < results.size() ? "," : "");
+		}
+		fprintf(file, "\t]\n}\n");
+
+		fclose(file);
+		return true;
+	}
+
+	static double percentile(const std::vector<double>& sorted_samples, const double fraction) {
+		const size_t index = std::min(size_t(fraction * (sorted_samples.size() - 1) + 0.5), sorted_samples.size() - 1);
+		return sorted_samples.at(index);
+	}
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+inline int countTrailingZeros(const uint64_t value) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return int(index);
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+// One bit per cell, 64 cells per word. The bits past the width of each row are kept at the outside value,
+// so that shifted neighbors read the same thing past the right edge as past the other edges.
+struct BitGrid {
+	int width;
+	int height;
+	int words;
+	bool outside;
+	std::vector<uint64_t> bits;
+
+	BitGrid(const int _width, const int _height, const bool _outside) :
+		width(_width), height(_height), words((_width + 63) / 64), outside(_outside), bits(size_t(words) * _height, _outside ? ~uint64_t(0) : 0) {
+	}
+
+	bool get(const int x, const int y) const {
+		if (x < 0 || x >= width || y < 0 || y >= height) {
+			return outside;
+		}
+		return (bits[size_t(y) * words + x / 64] >> (x % 64)) & 1;
+	}
+
+	void set(const int x, const int y, const bool value) {
+		uint64_t& word = bits[size_t(y) * words + x / 64];
+		const uint64_t mask = uint64_t(1) << (x % 64);
+		word = value ? (word | mask) : (word & ~mask);
+	}
+
+	void fill(const glm::ivec2& min, const glm::ivec2& max, const bool value) {
+		for (int y = std::max(min.y, 0); y <= std::min(max.y, height - 1); ++y) {
+			for (int x = std::max(min.x, 0); x <= std::min(max.x, width - 1); ++x) {
+				set(x, y, value);
+			}
+		}
+	}
+
+	uint64_t word(const int x_word, const int y) const {
+		if (x_word < 0 || x_word >= words || y < 0 || y >= height) {
+			return outside ? ~uint64_t(0) : 0;
+		}
+		return bits[size_t(y) * words + x_word];
+	}
+
+	// Bits of the cells one to the left (x - 1) or to the right (x + 1) of the cells of a word
+	uint64_t leftNeighbors(const int x_word, const int y) const {
+		return (word(x_word, y) << 1) | (word(x_word - 1, y) >> 63);
+	}
+
+	uint64_t rightNeighbors(const int x_word, const int y) const {
+		return (word(x_word, y) >> 1) | (word(x_word + 1, y) << 63);
+	}
+
+	void restorePadding() {
+		if (width % 64 == 0) {
+			return;
+		}
+
+		const uint64_t padding = ~uint64_t(0) << (width % 64);
+		for (int y = 0; y < height; ++y) {
+			uint64_t& last = bits[size_t(y) * words + words - 1];
+			last = outside ? (last | padding) : (last & ~padding);
+		}
+	}
+
+	// First x in [x_min, x_max] of the row whose bit has the value, x_max + 1 if there's none, a word at a time
+	int find(const int y, const int x_min, const int x_max, const bool value) const {
+		// An empty range can start one word past the row
+		if (x_min > x_max) {
+			return x_max + 1;
+		}
+
+		const uint64_t* row = &bits[size_t(y) * words];
+		const uint64_t flip = value ? 0 : ~uint64_t(0);
+
+		int x_word = x_min / 64;
+		uint64_t word = (row[x_word] ^ flip) & (~uint64_t(0) << (x_min % 64));
+		while (word == 0) {
+			++x_word;
+			if (x_word * 64 > x_max) {
+				return x_max + 1;
+			}
+			word = row[x_word] ^ flip;
+		}
+
+		return std::min(x_word * 64 + countTrailingZeros(word), x_max + 1);
+	}
+
+	// Sets the bits in [x_min, x_max] of the row, a word at a time
+	void setSpan(const int y, const int x_min, const int x_max) {
+		uint64_t* row = &bits[size_t(y) * words];
+		const int first_word = x_min / 64;
+		const int last_word = x_max / 64;
+		const uint64_t first_mask = ~uint64_t(0) << (x_min % 64);
+		const uint64_t last_mask = ~uint64_t(0) >> (63 - x_max % 64);
+
+		if (first_word == last_word) {
+			row[first_word] |= first_mask & last_mask;
+			return;
+		}
+
+		row[first_word] |= first_mask;
+		for (int x_word = first_word + 1; x_word < last_word; ++x_word) {
+			row[x_word] = ~uint64_t(0);
+		}
+		row[last_word] |= last_mask;
+	}
+};
@@ -0,0 +1,414 @@
+#pragma once
+
+#include <raylib.h>
+#include <rlgl.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include "telemetry.h"
+
+#if defined(__EMSCRIPTEN__)
+#include <GLES2/gl2.h>
+#else
+extern "C" void (*glfwGetProcAddress(const char* name))(void);
+#endif
+
+#if defined(_WIN32)
+#define DD_GL_CALL __stdcall
+#else
+#define DD_GL_CALL
+#endif
+
+// Match video of the 64x64 logical canvas. Each captured frame is stored as the differences with the one before it:
+// the spans of pixels that changed, each span as runs of the same color. A capture file is a header followed by
+// the frames, each one as
+//
+//   varint ticks (since the previous frame), varint body size, body
+//   body: spans of varint skip (unchanged pixels since the previous span), varint length (pixels), then runs of
+//         varint count and the RGB color until the span is covered
+//
+// and the first frame is the difference with a black canvas.
+namespace CaptureCodec {
+	static constexpr int size = 64;
+	static constexpr int pixelCount = size * size;
+
+	struct Header {
+		char magic[4]; // "DDCP"
+		uint32_t version;
+		uint16_t width;
+		uint16_t height;
+		float tickRate;
+	};
+
+	static constexpr uint32_t version = 1;
+
+	using Canvas = std::array<uint8_t, pixelCount * 3>; // RGB, row major
+
+	inline void writeVarint(std::vector<uint8_t>& output, uint32_t value) {
+		while (value >= 0x80) {
+			output.push_back(uint8_t(value | 0x80));
+			value >>= 7;
+		}
+		output.push_back(uint8_t(value));
+	}
+
+	// False at the end of the input, or on a varint longer than 32 bits
+	inline bool readVarint(const uint8_t*& input, const uint8_t* end, uint32_t& value) {
+		value = 0;
+		for (int shift = 0; shift < 35 && input < end; shift += 7) {
+			const uint8_t byte = *input++;
+			value |= uint32_t(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	inline bool samePixel(const Canvas& canvas0, const Canvas& canvas1, const int pixel) {
+		return memcmp(&canvas0[size_t(pixel) * 3], &canvas1[size_t(pixel) * 3], 3) == 0;
+	}
+
+	// Appends the spans of current that differ from previous to body
+	inline void encode(const Canvas& previous, const Canvas& current, std::vector<uint8_t>& body) {
+		int span_end = 0;
+		int pixel = 0;
+
+		while (pixel < pixelCount) {
+			// Most rows don't change at all
+			if (pixel % size == 0 && memcmp(&previous[size_t(pixel) * 3], &current[size_t(pixel) * 3], size * 3) == 0) {
+				pixel += size;
+				continue;
+			}
+
+			if (samePixel(previous, current, pixel)) {
+				++pixel;
+				continue;
+			}
+
+			const int span_start = pixel;
+			while (pixel < pixelCount && !samePixel(previous, current, pixel)) {
+				++pixel;
+			}
+
+			writeVarint(body, uint32_t(span_start - span_end));
+			writeVarint(body, uint32_t(pixel - span_start));
+
+			for (int run_start = span_start; run_start < pixel;) {
+				int run_end = run_start + 1;
+				while (run_end < pixel && memcmp(&current[size_t(run_end) * 3], &current[size_t(run_start) * 3], 3) == 0) {
+					++run_end;
+				}
+
+				writeVarint(body, uint32_t(run_end - run_start));
+				body.insert(body.end(), &current[size_t(run_start) * 3], &current[size_t(run_start) * 3] + 3);
+				run_start = run_end;
+			}
+
+			span_end = pixel;
+		}
+	}
+
+	// Applies a body to the canvas of the previous frame, false if it's malformed
+	inline bool decode(const uint8_t* body, const uint8_t* end, Canvas& canvas) {
+		int pixel = 0;
+
+		while (body < end) {
+			uint32_t skip;
+			uint32_t length;
+			if (!readVarint(body, end, skip) || !readVarint(body, end, length) || pixel + int64_t(skip) + length > pixelCount) {
+				return false;
+			}
+
+			pixel += int(skip);
+			const int span_end = pixel + int(length);
+			while (pixel < span_end) {
+				uint32_t count;
+				if (!readVarint(body, end, count) || count == 0 || pixel + int64_t(count) > span_end || end - body < 3) {
+					return false;
+				}
+
+				for (uint32_t i = 0; i < count; ++i, ++pixel) {
+					memcpy(&canvas[size_t(pixel) * 3], body, 3);
+				}
+				body += 3;
+			}
+		}
+
+		return true;
+	}
+}
+
+// The OpenGL entry points of the capture readback, which raylib doesn't wrap. Pixel buffers need desktop OpenGL 2.1 or
+// later; without them, on the web for example, every frame is read synchronously.
+namespace CaptureGl {
+	static constexpr unsigned int rgba = 0x1908;
+	static constexpr unsigned int unsignedByte = 0x1401;
+	static constexpr unsigned int pixelPackBuffer = 0x88EB;
+	static constexpr unsigned int streamRead = 0x88E1;
+	static constexpr unsigned int mapReadBit = 0x0001;
+
+	struct Functions {
+		void (DD_GL_CALL* readPixels)(int x, int y, int width, int height, unsigned int format, unsigned int type, void* pixels) = nullptr;
+		void (DD_GL_CALL* genBuffers)(int count, unsigned int* buffers) = nullptr;
+		void (DD_GL_CALL* deleteBuffers)(int count, const unsigned int* buffers) = nullptr;
+		void (DD_GL_CALL* bindBuffer)(unsigned int target, unsigned int buffer) = nullptr;
+		void (DD_GL_CALL* bufferData)(unsigned int target, ptrdiff_t size, const void* data, unsigned int usage) = nullptr;
+		void* (DD_GL_CALL* mapBufferRange)(unsigned int target, ptrdiff_t offset, ptrdiff_t length, unsigned int access) = nullptr;
+		unsigned char (DD_GL_CALL* unmapBuffer)(unsigned int target) = nullptr;
+
+		bool hasPixelBuffers() const {
+			return genBuffers != nullptr && deleteBuffers != nullptr && bindBuffer != nullptr && bufferData != nullptr && mapBufferRange != nullptr && unmapBuffer != nullptr;
+		}
+	};
+
+	template<typename Function>
+	void load(Function& function, const char* name) {
+#if defined(__EMSCRIPTEN__)
+		(void)name;
+		function = nullptr;
+#else
+		function = reinterpret_cast<Function>(glfwGetProcAddress(name));
+#endif
+	}
+
+	// Needs the context of the window
+	inline Functions load() {
+		Functions functions;
+#if defined(__EMSCRIPTEN__)
+		functions.readPixels = glReadPixels;
+#else
+		load(functions.readPixels, "glReadPixels");
+		const int version = rlGetVersion();
+		if (version == RL_OPENGL_21 || version == RL_OPENGL_33 || version == RL_OPENGL_43) {
+			load(functions.genBuffers, "glGenBuffers");
+			load(functions.deleteBuffers, "glDeleteBuffers");
+			load(functions.bindBuffer, "glBindBuffer");
+			load(functions.bufferData, "glBufferData");
+			load(functions.mapBufferRange, "glMapBufferRange");
+			load(functions.unmapBuffer, "glUnmapBuffer");
+		}
+#endif
+		return functions;
+	}
+}
+
+// Records the logical canvas while a match is played. The game draws the frame between begin() and end(), which
+// starts reading it back into one of two pixel buffers and encodes the frame read into the other one at the previous
+// end(), so the game never waits for the frame it has just drawn. The encoded bytes go into a ring, and a writer
+// thread drains the ring to the file. Frames that don't fit in the ring are dropped whole, and the next one is encoded
+// against the last frame that made it, so the file stays decodable.
+class MatchCapture {
+public:
+	MatchCapture(const std::filesystem::path& path, const float tick_rate, const size_t capacity = 1 << 20) : ring(capacity), batch(64 * 1024) {
+		// Worst case of a frame, where every pixel differs from both of its neighbours
+		body.reserve(size_t(CaptureCodec::pixelCount) * 8);
+		record.reserve(body.capacity() + 16);
+
+		file = fopen(path.string().c_str(), "wb");
+		if (file == nullptr) {
+			return;
+		}
+
+		CaptureCodec::Header header;
+		memcpy(header.magic, "DDCP", 4);
+		header.version = CaptureCodec::version;
+		header.width = CaptureCodec::size;
+		header.height = CaptureCodec::size;
+		header.tickRate = tick_rate;
+		fwrite(&header, sizeof(header), 1, file);
+
+		target = LoadRenderTexture(CaptureCodec::size, CaptureCodec::size);
+
+		gl = CaptureGl::load();
+		if (gl.hasPixelBuffers()) {
+			gl.genBuffers(2, pixelBuffers.data());
+			for (const unsigned int buffer : pixelBuffers) {
+				gl.bindBuffer(CaptureGl::pixelPackBuffer, buffer);
+				gl.bufferData(CaptureGl::pixelPackBuffer, ptrdiff_t(pixels.size()), nullptr, CaptureGl::streamRead);
+			}
+			gl.bindBuffer(CaptureGl::pixelPackBuffer, 0);
+		}
+
+#if DD_TELEMETRY_THREAD
+		writer = std::thread([this]() { writeLoop(); });
+#endif
+	}
+
+	MatchCapture(const MatchCapture&) = delete;
+	MatchCapture& operator=(const MatchCapture&) = delete;
+
+	~MatchCapture() {
+		if (file == nullptr) {
+			return;
+		}
+
+		// The last frame is still being read
+		if (reading >= 0) {
+			encodeBuffer(reading, readingTicks);
+		}
+		if (pixelBuffers[0] != 0) {
+			gl.deleteBuffers(2, pixelBuffers.data());
+		}
+		UnloadRenderTexture(target);
+
+		running.store(false, std::memory_order_release);
+#if DD_TELEMETRY_THREAD
+		writer.join();
+#else
+		writeLoop();
+#endif
+		fclose(file);
+	}
+
+	bool isOpen() const {
+		return file != nullptr;
+	}
+
+	// Starts drawing the frame, with the camera of the canvas
+	void begin() {
+		BeginTextureMode(target);
+		ClearBackground(BLACK);
+	}
+
+	// Ends the frame, which covers the given number of ticks since the previous one
+	void end(const int ticks) {
+		EndTextureMode();
+
+		if (gl.readPixels == nullptr) {
+			pendingTicks += ticks;
+			dropped += 1;
+			return;
+		}
+
+		rlEnableFramebuffer(target.id);
+		if (pixelBuffers[0] == 0) {
+			// Waits for the frame to be drawn
+			gl.readPixels(0, 0, CaptureCodec::size, CaptureCodec::size, CaptureGl::rgba, CaptureGl::unsignedByte, pixels.data());
+			rlDisableFramebuffer();
+			encodePixels(pixels.data(), ticks);
+			return;
+		}
+
+		const int buffer = (reading + 1) % 2;
+		gl.bindBuffer(CaptureGl::pixelPackBuffer, pixelBuffers[buffer]);
+		gl.readPixels(0, 0, CaptureCodec::size, CaptureCodec::size, CaptureGl::rgba, CaptureGl::unsignedByte, nullptr);
+		gl.bindBuffer(CaptureGl::pixelPackBuffer, 0);
+		rlDisableFramebuffer();
+
+		// The previous frame has had a whole frame to arrive
+		if (reading >= 0) {
+			encodeBuffer(reading, readingTicks);
+		}
+		reading = buffer;
+		readingTicks = ticks;
+	}
+
+	uint64_t frames() const {
+		return pushedFrames;
+	}
+
+	uint64_t droppedFrames() const {
+		return dropped;
+	}
+
+	uint64_t bytes() const {
+		return pushedBytes;
+	}
+
+private:
+	SpscRing<uint8_t> ring;
+	std::vector<uint8_t> batch;
+	std::atomic<bool> running{ true };
+	FILE* file = nullptr;
+#if DD_TELEMETRY_THREAD
+	std::thread writer;
+#endif
+
+	RenderTexture2D target{};
+	CaptureGl::Functions gl;
+	std::array<unsigned int, 2> pixelBuffers{}; // None without pixel buffers, frames are then read into pixels
+	std::array<uint8_t, CaptureCodec::pixelCount * 4> pixels{}; // RGBA, bottom row first
+	int reading = -1; // Pixel buffer of the frame being read
+	int readingTicks = 0;
+	CaptureCodec::Canvas previous{}; // Last frame in the ring
+	CaptureCodec::Canvas current{};
+	std::vector<uint8_t> body;
+	std::vector<uint8_t> record;
+	int pendingTicks = 0; // Of the dropped frames, added to the next one
+	uint64_t pushedFrames = 0;
+	uint64_t pushedBytes = 0;
+	uint64_t dropped = 0;
+
+	void encodeBuffer(const int buffer, const int ticks) {
+		gl.bindBuffer(CaptureGl::pixelPackBuffer, pixelBuffers[buffer]);
+		const void* mapped = gl.mapBufferRange(CaptureGl::pixelPackBuffer, 0, ptrdiff_t(pixels.size()), CaptureGl::mapReadBit);
+		if (mapped != nullptr) {
+			encodePixels(static_cast<const uint8_t*>(mapped), ticks);
+			gl.unmapBuffer(CaptureGl::pixelPackBuffer);
+		}
+		else {
+			pendingTicks += ticks;
+			dropped += 1;
+		}
+		gl.bindBuffer(CaptureGl::pixelPackBuffer, 0);
+	}
+
+	void encodePixels(const uint8_t* rgba, const int ticks) {
+		// Render textures are upside down
+		for (int y = 0; y < CaptureCodec::size; ++y) {
+			const uint8_t* row = rgba + size_t(CaptureCodec::size - 1 - y) * CaptureCodec::size * 4;
+			for (int x = 0; x < CaptureCodec::size; ++x) {
+				memcpy(&current[(size_t(y) * CaptureCodec::size + x) * 3], row + x * 4, 3);
+			}
+		}
+		push(ticks);
+	}
+
+	void push(const int ticks) {
+		body.clear();
+		CaptureCodec::encode(previous, current, body);
+
+		record.clear();
+		CaptureCodec::writeVarint(record, uint32_t(pendingTicks + ticks));
+		CaptureCodec::writeVarint(record, uint32_t(body.size()));
+		record.insert(record.end(), body.begin(), body.end());
+
+		if (file != nullptr && ring.push(record.data(), record.size())) {
+			previous = current;
+			pendingTicks = 0;
+			pushedFrames += 1;
+			pushedBytes += record.size();
+		}
+		else {
+			pendingTicks += ticks;
+			dropped += 1;
+		}
+	}
+
+	void writeLoop() {
+		while (true) {
+			const bool stopping = !running.load(std::memory_order_acquire);
+			const size_t count = ring.pop(batch.data(), batch.size());
+			if (count > 0) {
+				fwrite(batch.data(), 1, count, file);
+			}
+			else if (stopping) {
+				break;
+			}
+			else {
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+		}
+
+		fflush(file);
+	}
+};
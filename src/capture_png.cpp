@@ -0,0 +1,107 @@
+#include <raylib.h>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "capture.h"
+
+// Converts a match capture written by the game (F6) into a PNG sequence, one image per captured frame:
+// destructive_drones_capture <capture.ddcap> <output directory> [--scale N]
+// The frames are named by the tick they were captured at, so that a video encoder can space them by the tick rate.
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		printf("Usage: %s <capture.ddcap> <output directory> [--scale N]\n", argv[0]);
+		return 1;
+	}
+
+	int scale = 1;
+	for (int i = 3; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--scale" && i + 1 < argc) {
+			scale = std::max(std::atoi(argv[++i]), 1);
+		}
+		else {
+			printf("Usage: %s <capture.ddcap> <output directory> [--scale N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	FILE* input = fopen(argv[1], "rb");
+	if (input == nullptr) {
+		printf("Couldn't read %s\n", argv[1]);
+		return 1;
+	}
+
+	CaptureCodec::Header header;
+	if (fread(&header, sizeof(header), 1, input) != 1 || memcmp(header.magic, "DDCP", 4) != 0 || header.version != CaptureCodec::version ||
+		header.width != CaptureCodec::size || header.height != CaptureCodec::size) {
+		printf("%s is not a match capture\n", argv[1]);
+		fclose(input);
+		return 1;
+	}
+
+	std::vector<uint8_t> data;
+	{
+		std::array<uint8_t, 64 * 1024> chunk;
+		size_t count;
+		while ((count = fread(chunk.data(), 1, chunk.size(), input)) > 0) {
+			data.insert(data.end(), chunk.begin(), chunk.begin() + count);
+		}
+	}
+	fclose(input);
+
+	const std::filesystem::path output_directory = argv[2];
+	std::error_code error;
+	std::filesystem::create_directories(output_directory, error);
+
+	SetTraceLogLevel(LOG_WARNING);
+
+	CaptureCodec::Canvas canvas{};
+	std::vector<uint8_t> pixels(size_t(CaptureCodec::pixelCount) * 4);
+	uint64_t tick = 0;
+	int frames = 0;
+
+	const uint8_t* position = data.data();
+	const uint8_t* end = data.data() + data.size();
+	while (position < end) {
+		uint32_t ticks;
+		uint32_t body_size;
+		if (!CaptureCodec::readVarint(position, end, ticks) || !CaptureCodec::readVarint(position, end, body_size) || size_t(end - position) < body_size ||
+			!CaptureCodec::decode(position, position + body_size, canvas)) {
+			printf("The capture is truncated after %d frames\n", frames);
+			break;
+		}
+		position += body_size;
+		tick += ticks;
+
+		for (int i = 0; i < CaptureCodec::pixelCount; ++i) {
+			memcpy(&pixels[size_t(i) * 4], &canvas[size_t(i) * 3], 3);
+			pixels[size_t(i) * 4 + 3] = 255;
+		}
+
+		Image image{ pixels.data(), CaptureCodec::size, CaptureCodec::size, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+		Image scaled = ImageCopy(image);
+		if (scale > 1) {
+			ImageResizeNN(&scaled, CaptureCodec::size * scale, CaptureCodec::size * scale);
+		}
+
+		std::array<char, 32> filename;
+		snprintf(filename.data(), filename.size(), "tick%07llu.png", (unsigned long long)tick);
+		const bool exported = ExportImage(scaled, (output_directory / filename.data()).string().c_str());
+		UnloadImage(scaled);
+		if (!exported) {
+			printf("Couldn't write %s\n", (output_directory / filename.data()).string().c_str());
+			return 1;
+		}
+
+		++frames;
+	}
+
+	const double seconds = double(tick) / header.tickRate;
+	printf("%d frames over %.1f s, %zu bytes, %.1f KB/s\n", frames, seconds, data.size() + sizeof(header),
+		seconds > 0 ? double(data.size() + sizeof(header)) / 1024.0 / seconds : 0.0);
+	return 0;
+}
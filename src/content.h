@@ -0,0 +1,187 @@
+#pragma once
+
+#include <raylib.h>
+#include <array>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "pack.h"
+
+// Copies of one sound sharing the same samples, so that it can overlap with itself
+struct SoundVoices {
+	std::vector<Sound> voices;
+	size_t nextVoice = 0;
+
+	void load(const Wave& wave, const int count) {
+		for (int i = 0; i < count; ++i) {
+			voices.push_back(LoadSoundFromWave(wave));
+		}
+	}
+
+	void unload() {
+		for (Sound& voice : voices) {
+			UnloadSound(voice);
+		}
+		voices.clear();
+	}
+};
+
+// Loads from assets.pack when there is one, otherwise from the loose files of the data directory
+struct Content {
+	static constexpr int voicesPerSound = 4;
+
+	AssetPack pack{ "assets.pack" };
+
+	Texture pixel;
+
+	Texture drone;
+	Texture machinegun;
+	Texture laser;
+	Texture rocketlauncher;
+
+	Texture button_back;
+	Texture button_credits;
+	Texture button_four;
+	Texture button_help;
+	Texture button_one;
+	Texture button_play;
+	Texture button_three;
+	Texture button_two;
+	Texture button_zero;
+	Texture credits;
+	Texture help1;
+	Texture help2;
+	Texture help3;
+	Texture select_players;
+	Texture splash;
+	Texture rankings;
+
+	Sound menuSound;
+	SoundVoices reloadSound;
+	std::array<SoundVoices, 2> weaponSounds;
+
+	Content() {
+		pixel = loadTexture("pixel.png");
+
+		drone = loadTexture("drone.png");
+		machinegun = loadTexture("machinegun.png");
+		laser = loadTexture("laser.png");
+		rocketlauncher = loadTexture("rocketlauncher.png");
+
+		button_back = loadTexture("ui/button_back.png");
+		button_credits = loadTexture("ui/button_credits.png");
+		button_four = loadTexture("ui/button_four.png");
+		button_help = loadTexture("ui/button_help.png");
+		button_one = loadTexture("ui/button_one.png");
+		button_play = loadTexture("ui/button_play.png");
+		button_three = loadTexture("ui/button_three.png");
+		button_two = loadTexture("ui/button_two.png");
+		button_zero = loadTexture("ui/button_zero.png");
+		credits = loadTexture("ui/credits.png");
+		help1 = loadTexture("ui/help1.png");
+		help2 = loadTexture("ui/help2.png");
+		help3 = loadTexture("ui/help3.png");
+		select_players = loadTexture("ui/select_players.png");
+		splash = loadTexture("ui/splash.png");
+		rankings = loadTexture("ui/rankings.png");
+
+		{
+			Wave wave = loadWave("menu.mp3");
+			menuSound = LoadSoundFromWave(wave);
+			UnloadWave(wave);
+		}
+
+		{
+			Wave wave = loadWave("reload.mp3");
+			reloadSound.load(wave, voicesPerSound);
+			UnloadWave(wave);
+		}
+
+		{
+			Wave wave = loadWave("shot.mp3");
+			weaponSounds.at(0).load(wave, voicesPerSound);
+			UnloadWave(wave);
+		}
+
+		{
+			Wave wave = loadWave("rocket.mp3");
+			weaponSounds.at(1).load(wave, voicesPerSound);
+			UnloadWave(wave);
+		}
+
+		// Only counted here, the frames are decoded when they are first shown
+		while (pack.find(menuVideoPath(menuVideo.size())) != nullptr || std::filesystem::exists(menuVideoPath(menuVideo.size()))) {
+			menuVideo.push_back(Texture{});
+		}
+	}
+
+	size_t menuVideoFrames() const {
+		return menuVideo.size();
+	}
+
+	const Texture& menuVideoFrame(const size_t index) {
+		Texture& frame = menuVideo.at(index);
+		if (frame.id == 0) {
+			frame = loadTexture(menuVideoPath(index));
+		}
+		return frame;
+	}
+
+	~Content() {
+		UnloadTexture(pixel);
+
+		UnloadTexture(drone);
+		UnloadTexture(machinegun);
+		UnloadTexture(laser);
+		UnloadTexture(rocketlauncher);
+
+		UnloadTexture(button_back);
+		UnloadTexture(button_credits);
+		UnloadTexture(button_four);
+		UnloadTexture(button_help);
+		UnloadTexture(button_one);
+		UnloadTexture(button_play);
+		UnloadTexture(button_three);
+		UnloadTexture(button_two);
+		UnloadTexture(button_zero);
+		UnloadTexture(credits);
+		UnloadTexture(help1);
+		UnloadTexture(help2);
+		UnloadTexture(help3);
+		UnloadTexture(select_players);
+		UnloadTexture(splash);
+		UnloadTexture(rankings);
+
+		for (Texture& frame : menuVideo) {
+			if (frame.id != 0) {
+				UnloadTexture(frame);
+			}
+		}
+		menuVideo.clear();
+
+		UnloadSound(menuSound);
+		reloadSound.unload();
+		for (SoundVoices& sound : weaponSounds) {
+			sound.unload();
+		}
+	}
+
+private:
+	std::vector<Texture> menuVideo;
+
+	static std::string menuVideoPath(const size_t index) {
+		std::array<char, 64> filename;
+		snprintf(filename.data(), filename.size(), "video/menu%04d.png", int(index) + 1);
+		return filename.data();
+	}
+
+	Texture loadTexture(const std::string& path) const {
+		const Texture texture = pack.loadTexture(path);
+		return texture.id != 0 ? texture : LoadTexture(path.c_str());
+	}
+
+	Wave loadWave(const std::string& path) const {
+		const Wave wave = pack.loadWave(path);
+		return wave.data != nullptr ? wave : LoadWave(path.c_str());
+	}
+};
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Maps compiled into the binary. The build turns each map CSV into a string literal (cmake/embed_maps.cmake), and
+// these constexpr functions parse and check it while compiling, so a built-in map costs no file access or parsing at
+// runtime, and a broken map fails the build. The error is the argument of the badMap call the compiler points at.
+namespace EmbeddedMaps {
+	static constexpr int footprint = 4; // Drones and items are 4x4
+	static constexpr int maxSpawns = 64;
+
+	// Player or item spawn, with the value it has in the CSV: 2 player, 4-6 weapons
+	struct Spawn {
+		int x;
+		int y;
+		int type;
+	};
+
+	// Not constexpr, calling it during constant evaluation stops the compilation with the message
+	inline void badMap(const char*) {
+	}
+
+	template<int Width, int Height>
+	struct Map {
+		std::array<int8_t, size_t(Width) * Height> tiles{}; // -1 empty, 0 solid, 1 bedrock, row major
+		std::array<Spawn, maxSpawns> spawns{}; // In the order of the CSV
+		int spawnCount = 0;
+	};
+
+	// Map of any size, what Level is built from
+	struct View {
+		const char* name;
+		int width;
+		int height;
+		const int8_t* tiles;
+		const Spawn* spawns;
+		int spawnCount;
+
+		template<int Width, int Height>
+		constexpr View(const char* _name, const Map<Width, Height>& map) :
+			name(_name), width(Width), height(Height), tiles(map.tiles.data()), spawns(map.spawns.data()), spawnCount(map.spawnCount) {
+		}
+	};
+
+	// Values in the first line
+	template<size_t N>
+	constexpr int columns(const char (&csv)[N]) {
+		int count = 1;
+		for (size_t i = 0; i < N - 1 && csv[i] != '\n'; ++i) {
+			count += csv[i] == ',' ? 1 : 0;
+		}
+		return count;
+	}
+
+	// Lines that aren't empty
+	template<size_t N>
+	constexpr int rows(const char (&csv)[N]) {
+		int count = 0;
+		bool empty = true;
+		for (size_t i = 0; i < N - 1; ++i) {
+			if (csv[i] == '\n') {
+				count += empty ? 0 : 1;
+				empty = true;
+			}
+			else if (csv[i] != '\r') {
+				empty = false;
+			}
+		}
+		return count + (empty ? 0 : 1);
+	}
+
+	template<int Width, int Height>
+	constexpr bool footprintIsFree(const Map<Width, Height>& map, const int x, const int y) {
+		if (x + footprint > Width || y + footprint > Height) {
+			return false;
+		}
+		for (int i = y; i < y + footprint; ++i) {
+			for (int j = x; j < x + footprint; ++j) {
+				if (map.tiles[size_t(i) * Width + j] >= 0) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Reads the values of the CSV in the encoding of Level::loadLevel
+	template<int Width, int Height, size_t N>
+	constexpr Map<Width, Height> parse(const char (&csv)[N]) {
+		static_assert(Width > 0 && Height > 0, "Empty map");
+
+		Map<Width, Height> map;
+		size_t i = 0;
+
+		for (int y = 0; y < Height; ++y) {
+			while (i < N - 1 && (csv[i] == '\n' || csv[i] == '\r')) {
+				++i;
+			}
+
+			for (int x = 0; x < Width; ++x) {
+				const bool negative = csv[i] == '-';
+				i += negative ? 1 : 0;
+				if (csv[i] < '0' || csv[i] > '9') {
+					badMap("A value isn't a number");
+				}
+
+				int value = 0;
+				while (csv[i] >= '0' && csv[i] <= '9') {
+					value = value * 10 + (csv[i] - '0');
+					++i;
+				}
+				value = negative ? -value : value;
+
+				if (x + 1 < Width) {
+					if (csv[i] != ',') {
+						badMap("A row has fewer values than the first one");
+					}
+					++i;
+				}
+				else if (csv[i] != '\r' && csv[i] != '\n' && csv[i] != '\0') {
+					badMap("A row has more values than the first one");
+				}
+
+				int8_t tile = -1;
+				if (value == 0 || value == 1) {
+					tile = int8_t(value);
+				}
+				else if (value == 2 || value == 4 || value == 5 || value == 6) {
+					if (map.spawnCount == maxSpawns) {
+						badMap("Too many spawns");
+					}
+					map.spawns[map.spawnCount] = Spawn{ x, y, value };
+					++map.spawnCount;
+				}
+				else if (value != -1) {
+					badMap("Unknown tile value, the values are -1 empty, 0 solid, 1 bedrock, 2 player spawn, 4-6 weapon spawns");
+				}
+				map.tiles[size_t(y) * Width + x] = tile;
+			}
+		}
+
+		int player_spawns = 0;
+		for (int s = 0; s < map.spawnCount; ++s) {
+			const Spawn& spawn = map.spawns[s];
+			player_spawns += spawn.type == 2 ? 1 : 0;
+			if (!footprintIsFree(map, spawn.x, spawn.y)) {
+				badMap("A spawn's 4x4 footprint is outside the map or overlaps solid tiles");
+			}
+		}
+
+		if (player_spawns == 0) {
+			badMap("The map has no player spawn");
+		}
+
+		return map;
+	}
+}
@@ -0,0 +1,325 @@
+#include "env.h"
+
+#include <raylib.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "settings.h"
+#include "level.h"
+#include "session.h"
+#include "embedded_maps.h"
+
+// Calls a function for every index of a range on persistent threads, the calling thread taking its share, and
+// returns when all of them are done. Indices are handed out one at a time, sessions don't all cost the same.
+class WorkerPool {
+public:
+	WorkerPool(const int thread_count) {
+		for (int i = 1; i < thread_count; ++i) {
+			threads.emplace_back([this]() { work(); });
+		}
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	~WorkerPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wakeUp.notify_all();
+
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+	}
+
+	void run(const size_t count, const std::function<void(size_t)>& function) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = &function;
+			jobCount = count;
+			next = 0;
+			pending = threads.size();
+			++generation;
+		}
+		wakeUp.notify_all();
+
+		drain();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [this]() { return pending == 0; });
+	}
+
+private:
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::condition_variable finished;
+	const std::function<void(size_t)>* job = nullptr;
+	size_t jobCount = 0;
+	std::atomic<size_t> next{ 0 };
+	size_t pending = 0; // Threads that haven't finished the current run
+	uint64_t generation = 0;
+	bool stopping = false;
+
+	void drain() {
+		for (size_t index = next.fetch_add(1); index < jobCount; index = next.fetch_add(1)) {
+			(*job)(index);
+		}
+	}
+
+	void work() {
+		uint64_t last_generation = 0;
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (true) {
+			wakeUp.wait(lock, [&]() { return stopping || generation != last_generation; });
+			if (stopping) {
+				return;
+			}
+			last_generation = generation;
+
+			lock.unlock();
+			drain();
+			lock.lock();
+
+			if (--pending == 0) {
+				finished.notify_one();
+			}
+		}
+	}
+};
+
+// One session of the batch, with what the rewards are measured against
+struct EnvSlot {
+	std::unique_ptr<Session> session;
+	uint64_t ticks = 0;
+	std::array<int, Settings::maxPlayers> kills{};
+	std::array<bool, Settings::maxPlayers> alive{};
+};
+
+struct DDEnv {
+	DDEnvConfig config;
+	Settings settings;
+	std::shared_ptr<const Level> level;
+	std::vector<EnvSlot> slots;
+	std::unique_ptr<WorkerPool> workers;
+
+	int players() const {
+		return config.agentsPerEnv + config.botsPerEnv;
+	}
+
+	void remember(EnvSlot& slot) {
+		for (const Player& player : slot.session->players) {
+			slot.kills.at(player.playerIndex) = player.kills;
+			slot.alive.at(player.playerIndex) = player.health > 0;
+		}
+	}
+
+	void restart(EnvSlot& slot) {
+		slot.session->restart(*level);
+		slot.ticks = 0;
+		remember(slot);
+	}
+
+	// Holds the actions for ticksPerStep ticks, restarting the session if it ends. Kills and deaths are counted on
+	// every tick, a drone can't die and respawn unnoticed.
+	void step(const size_t index, const float* actions, const DDEnvObservations& observations) {
+		EnvSlot& slot = slots.at(index);
+		Session& session = *slot.session;
+		float* const rewards = observations.rewards != nullptr ? observations.rewards + index * config.agentsPerEnv : nullptr;
+
+		for (int agent = 0; agent < config.agentsPerEnv; ++agent) {
+			const float* action = actions + (index * config.agentsPerEnv + agent) * DD_ENV_ACTION_SIZE;
+			PlayerInput& input = std::next(session.players.begin(), agent)->input;
+			input.move = glm::vec2(action[0], action[1]);
+			input.shoot = glm::vec2(action[2], action[3]);
+			input.fire = action[4] > 0.5f;
+
+			if (rewards != nullptr) {
+				rewards[agent] = 0;
+			}
+		}
+
+		bool done = false;
+		const float tick_time = 1.0f / settings.tickRate;
+		for (int tick = 0; tick < config.ticksPerStep && !done; ++tick) {
+			session.update(tick_time);
+			++slot.ticks;
+
+			// Players are added in order, the agents come first
+			auto player = session.players.cbegin();
+			for (int agent = 0; agent < config.agentsPerEnv && rewards != nullptr; ++agent, ++player) {
+				// A suicide is only the death, the score it takes away isn't counted again
+				const bool died = slot.alive.at(agent) && player->health <= 0;
+				rewards[agent] += float(player->kills - slot.kills.at(agent)) - (died ? 1.0f : 0.0f);
+			}
+			remember(slot);
+
+			done = session.checkEndgame().has_value() || (config.maxTicks > 0 && slot.ticks >= uint64_t(config.maxTicks));
+		}
+
+		if (done) {
+			restart(slot);
+		}
+
+		if (observations.dones != nullptr) {
+			observations.dones[index] = done ? 1 : 0;
+		}
+		observe(index, observations);
+	}
+
+	void observe(const size_t index, const DDEnvObservations& observations) const {
+		const Session& session = *slots.at(index).session;
+		const Level& session_level = session.level;
+		const int width = session_level.width;
+		const int height = session_level.height;
+		const size_t tile_count = size_t(width) * height;
+		const glm::vec2 scale(1.0f / float(width), 1.0f / float(height));
+
+		if (observations.tiles != nullptr) {
+			float* tiles = observations.tiles + index * tile_count;
+			const float inverse_health = 1.0f / settings.tileHealth;
+			for (int y = 0; y < height; ++y) {
+				const Level::Tile* row = session_level.row(y);
+				for (int x = 0; x < width; ++x) {
+					tiles[size_t(y) * width + x] = std::clamp(row[x].solidity * inverse_health, 0.0f, 1.0f);
+				}
+			}
+		}
+
+		if (observations.players != nullptr) {
+			float* features = observations.players + index * players() * DD_ENV_PLAYER_FEATURES;
+			for (const Player& player : session.players) {
+				float* feature = features + player.playerIndex * DD_ENV_PLAYER_FEATURES;
+				const glm::vec2 center = (glm::vec2(player.bounds.position) + glm::vec2(player.bounds.size) * 0.5f) * scale;
+				feature[0] = player.health > 0 ? 1.0f : 0.0f;
+				feature[1] = center.x;
+				feature[2] = center.y;
+				feature[3] = std::max(player.health, 0.0f) / settings.playerMaxHealth;
+				feature[4] = player.weapon.has_value() ? float(player.ammo) / float(settings.weapons.at(*player.weapon).maxAmmo) : 0.0f;
+				feature[5] = float(player.score) / float(settings.scoreForWin);
+				for (int weapon = 0; weapon < weaponTypeCount; ++weapon) {
+					feature[6 + weapon] = player.weapon == WeaponType(weapon) ? 1.0f : 0.0f;
+				}
+				feature[9] = player.weaponReady ? 1.0f : 0.0f;
+			}
+		}
+
+		if (observations.items != nullptr) {
+			const std::vector<Level::ItemSpawn>& spawns = level->itemSpawns;
+			float* features = observations.items + index * spawns.size() * DD_ENV_ITEM_FEATURES;
+			for (size_t slot = 0; slot < spawns.size(); ++slot) {
+				const Level::ItemSpawn& spawn = spawns[slot];
+				const bool present = std::any_of(session.items.begin(), session.items.end(), [&spawn](const Item& item) { return item.bounds.position == spawn.position; });
+				const glm::vec2 center = (glm::vec2(spawn.position) + glm::vec2(2.0f)) * scale;
+
+				float* feature = features + slot * DD_ENV_ITEM_FEATURES;
+				feature[0] = present ? 1.0f : 0.0f;
+				feature[1] = center.x;
+				feature[2] = center.y;
+				feature[3] = float(spawn.type - ItemType::Weapon0);
+			}
+		}
+
+		if (observations.projectiles != nullptr) {
+			float* projectiles = observations.projectiles + index * tile_count;
+			std::fill(projectiles, projectiles + tile_count, 0.0f);
+			for (const PooledList<Projectile>& bucket : session.projectiles) {
+				for (const Projectile& projectile : bucket) {
+					if (Session::inLevel(projectile.bounds.position, session_level)) {
+						projectiles[size_t(projectile.bounds.position.y) * width + projectile.bounds.position.x] += 1.0f;
+					}
+				}
+			}
+		}
+	}
+};
+
+extern "C" {
+
+void dd_env_default_config(DDEnvConfig* config) {
+	config->envCount = 64;
+	config->agentsPerEnv = 1;
+	config->botsPerEnv = 3;
+	config->threadCount = 0;
+	config->ticksPerStep = 4;
+	config->maxTicks = 120 * 60 * 5;
+	config->seed = 0;
+	config->map = nullptr;
+}
+
+DDEnv* dd_env_create(const DDEnvConfig* config) {
+	const int players = config->agentsPerEnv + config->botsPerEnv;
+	if (config->envCount < 1 || config->agentsPerEnv < 1 || config->botsPerEnv < 0 || players > Settings::maxPlayers || config->ticksPerStep < 1) {
+		return nullptr;
+	}
+
+	SetTraceLogLevel(LOG_WARNING);
+
+	std::unique_ptr<DDEnv> env(new DDEnv());
+	env->config = *config;
+	env->config.map = nullptr; // Not kept, the caller owns the string
+
+	LevelCache levels(env->settings, { EmbeddedMaps::all.begin(), EmbeddedMaps::all.end() });
+	env->level = levels.get(config->map != nullptr ? config->map : "map0.csv");
+	if (env->level->width == 0 || env->level->playerSpawns.size() < size_t(players)) {
+		return nullptr;
+	}
+
+	env->slots.resize(size_t(config->envCount));
+	for (int i = 0; i < config->envCount; ++i) {
+		EnvSlot& slot = env->slots.at(i);
+		slot.session.reset(new Session(env->settings, *env->level, config->seed + unsigned(i)));
+		for (int player = 0; player < players; ++player) {
+			slot.session->addPlayer(player, player < config->agentsPerEnv ? Controller::Remote : Controller::Bot);
+		}
+		env->remember(slot);
+	}
+
+	const int thread_count = config->threadCount > 0 ? config->threadCount : int(std::max(std::thread::hardware_concurrency(), 1u));
+	env->workers.reset(new WorkerPool(std::min(thread_count, config->envCount)));
+	return env.release();
+}
+
+void dd_env_destroy(DDEnv* env) {
+	delete env;
+}
+
+void dd_env_info(const DDEnv* env, DDEnvInfo* info) {
+	info->envCount = env->config.envCount;
+	info->width = env->level->width;
+	info->height = env->level->height;
+	info->players = env->players();
+	info->agents = env->config.agentsPerEnv;
+	info->itemSlots = int(env->level->itemSpawns.size());
+}
+
+void dd_env_reset(DDEnv* env, const DDEnvObservations* observations) {
+	env->workers->run(env->slots.size(), [env, observations](const size_t index) {
+		env->restart(env->slots.at(index));
+		if (observations->rewards != nullptr) {
+			std::fill_n(observations->rewards + index * env->config.agentsPerEnv, env->config.agentsPerEnv, 0.0f);
+		}
+		if (observations->dones != nullptr) {
+			observations->dones[index] = 0;
+		}
+		env->observe(index, *observations);
+	});
+}
+
+void dd_env_step(DDEnv* env, const float* actions, const DDEnvObservations* observations) {
+	env->workers->run(env->slots.size(), [env, actions, observations](const size_t index) {
+		env->step(index, actions, *observations);
+	});
+}
+
+}
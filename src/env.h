@@ -0,0 +1,92 @@
+#ifndef DESTRUCTIVE_DRONES_ENV_H
+#define DESTRUCTIVE_DRONES_ENV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Batched training environment: a number of independent sessions stepped in lockstep on a pool of threads, without
+ * a window. The first agentsPerEnv drones of each session are driven by the caller's actions, the others by the
+ * built-in bots. Observations are written straight into the caller's arrays, which stay owned by the caller:
+ *
+ *   tiles        float [envs][height][width]            solidity of each tile, 0 empty to 1 intact
+ *   players      float [envs][players][DD_ENV_PLAYER_FEATURES]
+ *   items        float [envs][itemSlots][DD_ENV_ITEM_FEATURES], one slot per item spawn of the map
+ *   projectiles  float [envs][height][width]            projectiles on each tile
+ *   rewards      float [envs][agents]                   kills of other drones minus deaths during the step, a suicide is -1
+ *   dones        uint8 [envs]                           1 when the episode ended during the step
+ *
+ * Any of them can be NULL to skip it. Actions are float [envs][agents][DD_ENV_ACTION_SIZE], with the intents of a
+ * gamepad: move x, move y, aim x, aim y (normalized when not zero) and fire (when > 0.5).
+ * Sessions that finish, or reach maxTicks, are restarted within the step that ended them, which then observes the
+ * start of the next episode.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32) && defined(DD_ENV_BUILD)
+#define DD_ENV_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define DD_ENV_API __declspec(dllimport)
+#else
+#define DD_ENV_API __attribute__((visibility("default")))
+#endif
+
+enum {
+	DD_ENV_ACTION_SIZE = 5,
+	DD_ENV_PLAYER_FEATURES = 10, /* alive, x, y, health, ammo, score, machine gun, shotgun, rocket launcher, weapon ready */
+	DD_ENV_ITEM_FEATURES = 4, /* present, x, y, weapon index */
+};
+
+typedef struct DDEnvConfig {
+	int envCount;
+	int agentsPerEnv; /* Drones driven by the actions */
+	int botsPerEnv; /* Built-in bots after the agents */
+	int threadCount; /* 0 for one per core */
+	int ticksPerStep; /* Simulation ticks each action is held for */
+	int maxTicks; /* Episode length limit, 0 for none */
+	unsigned seed; /* Session i is seeded with seed + i */
+	const char* map; /* Built-in map name or CSV path, NULL for map0.csv */
+} DDEnvConfig;
+
+typedef struct DDEnvInfo {
+	int envCount;
+	int width;
+	int height;
+	int players; /* agents + bots */
+	int agents;
+	int itemSlots;
+} DDEnvInfo;
+
+typedef struct DDEnvObservations {
+	float* tiles;
+	float* players;
+	float* items;
+	float* projectiles;
+	float* rewards;
+	uint8_t* dones;
+} DDEnvObservations;
+
+typedef struct DDEnv DDEnv;
+
+/* Fills the config with the defaults */
+DD_ENV_API void dd_env_default_config(DDEnvConfig* config);
+
+/* NULL if the config is invalid, or the map can't be loaded or has fewer player spawns than agents + bots */
+DD_ENV_API DDEnv* dd_env_create(const DDEnvConfig* config);
+DD_ENV_API void dd_env_destroy(DDEnv* env);
+DD_ENV_API void dd_env_info(const DDEnv* env, DDEnvInfo* info);
+
+/* Starts a new episode in every session */
+DD_ENV_API void dd_env_reset(DDEnv* env, const DDEnvObservations* observations);
+
+/* Applies the actions and advances every session by ticksPerStep ticks */
+DD_ENV_API void dd_env_step(DDEnv* env, const float* actions, const DDEnvObservations* observations);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "env.h"
+
+/*
+ * Steps a batch of environments with random actions and reports the throughput, the way a training loop would
+ * drive the library: destructive_drones_env_demo [envs] [steps] [threads]
+ */
+static double seconds(void) {
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+	DDEnvConfig config;
+	dd_env_default_config(&config);
+	config.envCount = argc > 1 ? atoi(argv[1]) : 64;
+	const int steps = argc > 2 ? atoi(argv[2]) : 1000;
+	config.threadCount = argc > 3 ? atoi(argv[3]) : 0;
+
+	DDEnv* env = dd_env_create(&config);
+	if (env == NULL) {
+		printf("Couldn't create the environment\n");
+		return 1;
+	}
+
+	DDEnvInfo info;
+	dd_env_info(env, &info);
+
+	const size_t tile_count = (size_t)info.envCount * info.width * info.height;
+	const size_t action_count = (size_t)info.envCount * info.agents * DD_ENV_ACTION_SIZE;
+
+	DDEnvObservations observations;
+	observations.tiles = malloc(tile_count * sizeof(float));
+	observations.players = malloc((size_t)info.envCount * info.players * DD_ENV_PLAYER_FEATURES * sizeof(float));
+	observations.items = malloc((size_t)info.envCount * info.itemSlots * DD_ENV_ITEM_FEATURES * sizeof(float));
+	observations.projectiles = malloc(tile_count * sizeof(float));
+	observations.rewards = malloc((size_t)info.envCount * info.agents * sizeof(float));
+	observations.dones = malloc((size_t)info.envCount);
+	float* actions = malloc(action_count * sizeof(float));
+
+	dd_env_reset(env, &observations);
+
+	double reward_sum = 0;
+	int episodes = 0;
+	const double start = seconds();
+
+	for (int step = 0; step < steps; ++step) {
+		for (size_t i = 0; i < action_count; ++i) {
+			actions[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+		}
+
+		dd_env_step(env, actions, &observations);
+
+		for (int i = 0; i < info.envCount * info.agents; ++i) {
+			reward_sum += observations.rewards[i];
+		}
+		for (int i = 0; i < info.envCount; ++i) {
+			episodes += observations.dones[i];
+		}
+	}
+
+	const double elapsed = seconds() - start;
+	const double env_steps = (double)steps * info.envCount;
+	printf("%d envs %dx%d, %d agents + %d bots, %d ticks per step\n", info.envCount, info.width, info.height, info.agents, info.players - info.agents, config.ticksPerStep);
+	printf("%.0f env steps/s, %.1f million per hour, %d episodes ended, reward sum %.0f\n", env_steps / elapsed, env_steps / elapsed * 3600.0 / 1e6, episodes, reward_sum);
+
+	free(actions);
+	free(observations.dones);
+	free(observations.rewards);
+	free(observations.projectiles);
+	free(observations.items);
+	free(observations.players);
+	free(observations.tiles);
+	dd_env_destroy(env);
+	return 0;
+}
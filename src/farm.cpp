@@ -0,0 +1,353 @@
+#include <raylib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "settings.h"
+#include "level.h"
+#include "session.h"
+#include "weapons.h"
+
+// A tunable value of Settings, addressed by name from the command line
+struct Parameter {
+	std::string name;
+	std::function<void(Settings&, double)> apply;
+};
+
+std::vector<Parameter> settingsParameters() {
+	std::vector<Parameter> parameters{
+		{ "playerMaxHealth", [](Settings& settings, double value) { settings.playerMaxHealth = float(value); } },
+		{ "playerSpeed", [](Settings& settings, double value) { settings.playerSpeed = float(value); } },
+		{ "itemSpawnDelay", [](Settings& settings, double value) { settings.itemSpawnDelay = float(value); } },
+		{ "tileHealth", [](Settings& settings, double value) { settings.tileHealth = float(value); } },
+		{ "scoreForWin", [](Settings& settings, double value) { settings.scoreForWin = int(value); } },
+		{ "respawnTime", [](Settings& settings, double value) { settings.respawnTime = float(value); } },
+		{ "aiDangerLookahead", [](Settings& settings, double value) { settings.aiDangerLookahead = float(value); } },
+		{ "aiDodgeThreshold", [](Settings& settings, double value) { settings.aiDodgeThreshold = float(value); } },
+		{ "aiFlankTicks", [](Settings& settings, double value) { settings.aiFlankTicks = int(value); } },
+	};
+
+	static const std::array<const char*, weaponTypeCount> weapon_names{ "machinegun", "shotgun", "rocket" };
+	for (int i = 0; i < weaponTypeCount; ++i) {
+		const std::string prefix = std::string(weapon_names.at(i)) + ".";
+		parameters.push_back({ prefix + "maxAmmo", [i](Settings& settings, double value) { settings.weapons.at(i).maxAmmo = int(value); } });
+		parameters.push_back({ prefix + "shootDelay", [i](Settings& settings, double value) { settings.weapons.at(i).shootDelay = float(value); } });
+		parameters.push_back({ prefix + "projectileSpeed", [i](Settings& settings, double value) { settings.weapons.at(i).projectileSpeed = float(value); } });
+		parameters.push_back({ prefix + "projectileDamage", [i](Settings& settings, double value) { settings.weapons.at(i).projectileDamage = float(value); } });
+		parameters.push_back({ prefix + "projectileCount", [i](Settings& settings, double value) { settings.weapons.at(i).projectileCount = int(value); } });
+		parameters.push_back({ prefix + "projectileSpread", [i](Settings& settings, double value) { settings.weapons.at(i).projectileSpread = float(value); } });
+		parameters.push_back({ prefix + "projectileLife", [i](Settings& settings, double value) { settings.weapons.at(i).projectileLife = float(value); } });
+		parameters.push_back({ prefix + "blastRadius", [i](Settings& settings, double value) { settings.weapons.at(i).blastRadius = int(value); } });
+	}
+
+	return parameters;
+}
+
+// Values swept for one parameter: a list for grids, a range for random search
+struct Axis {
+	const Parameter* parameter;
+	std::vector<double> values;
+	double min;
+	double max;
+};
+
+struct Config {
+	Settings settings;
+	std::vector<double> values;
+	std::unique_ptr<Level> level;
+};
+
+struct MatchResult {
+	bool finished = false;
+	int winnerSpawn = -1;
+	uint64_t ticks = 0;
+	std::array<int, weaponTypeCount> kills{};
+	double seconds = 0;
+};
+
+// Plays a bot match with a fixed tick until someone wins or max_ticks is reached. The worker's session is reused
+// when it was made for the same config, restarted with the seed of the match, which plays it like a new session would.
+MatchResult playMatch(std::unique_ptr<Session>& session_storage, const Config& config, const int bots, const unsigned seed, const uint64_t max_ticks) {
+	const float tick_time = 1.0f / config.settings.tickRate;
+	const auto start = std::chrono::steady_clock::now();
+
+	if (session_storage && &session_storage->settings == &config.settings) {
+		session_storage->restart(*config.level, seed);
+	}
+	else {
+		session_storage.reset(new Session(config.settings, *config.level, seed));
+		for (int i = 0; i < bots; ++i) {
+			session_storage->addPlayer(i, Controller::Bot);
+		}
+	}
+	Session& session = *session_storage;
+
+	// The spawn each player started from, to see if some spawns are favored by the level
+	std::vector<int> player_spawns;
+	for (const Player& player : session.players) {
+		const auto spawn = std::find(config.level->playerSpawns.begin(), config.level->playerSpawns.end(), player.bounds.position);
+		player_spawns.push_back(int(spawn - config.level->playerSpawns.begin()));
+	}
+
+	MatchResult result;
+	while (result.ticks < max_ticks) {
+		session.update(tick_time);
+		++result.ticks;
+
+		if (const std::optional<std::vector<int>> rankings = session.checkEndgame()) {
+			result.finished = true;
+			result.winnerSpawn = player_spawns.at(rankings->front());
+			break;
+		}
+	}
+
+	result.kills = session.killsByWeapon;
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+bool parseAxis(const std::string& spec, const std::vector<Parameter>& parameters, const bool range, Axis& axis) {
+	const size_t equals = spec.find('=');
+	if (equals == std::string::npos) {
+		return false;
+	}
+
+	const std::string name = spec.substr(0, equals);
+	const auto parameter = std::find_if(parameters.begin(), parameters.end(), [&name](const Parameter& parameter) { return parameter.name == name; });
+	if (parameter == parameters.end()) {
+		printf("Unknown parameter %s\n", name.c_str());
+		return false;
+	}
+
+	axis.parameter = &*parameter;
+	const std::string values = spec.substr(equals + 1);
+
+	if (range) {
+		const size_t colon = values.find(':');
+		if (colon == std::string::npos) {
+			return false;
+		}
+		axis.min = std::atof(values.substr(0, colon).c_str());
+		axis.max = std::atof(values.substr(colon + 1).c_str());
+		return axis.min <= axis.max;
+	}
+
+	size_t begin = 0;
+	while (begin <= values.size()) {
+		const size_t end = std::min(values.find(',', begin), values.size());
+		axis.values.push_back(std::atof(values.substr(begin, end - begin).c_str()));
+		begin = end + 1;
+	}
+	return true;
+}
+
+// Plays seeded bot matches for every combination of a parameter grid, or for random samples of parameter ranges,
+// on all the cores, and writes one CSV row per configuration. Runs without a window, from the directory containing the game data:
+// destructive_drones_farm [--grid name=v0,v1,...]... [--random name=min:max --samples N]... [--matches N] [--bots N]
+//                         [--seed N] [--threads N] [--max-ticks N] [--map map0.csv] [--csv farm.csv] [--list]
+int main(int argc, char** argv) {
+	const std::vector<Parameter> parameters = settingsParameters();
+
+	std::vector<Axis> grid_axes;
+	std::vector<Axis> random_axes;
+	std::string map_path = "map0.csv";
+	std::string csv_path = "farm.csv";
+	int samples = 16;
+	int matches = 100;
+	int bots = 4;
+	unsigned seed = 1;
+	int thread_count = int(std::max(std::thread::hardware_concurrency(), 1u));
+	uint64_t max_ticks = uint64_t(Settings().tickRate) * 60 * 30;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		const bool has_value = i + 1 < argc;
+		Axis axis{};
+
+		if (arg == "--grid" && has_value && parseAxis(argv[++i], parameters, false, axis)) {
+			grid_axes.push_back(axis);
+		}
+		else if (arg == "--random" && has_value && parseAxis(argv[++i], parameters, true, axis)) {
+			random_axes.push_back(axis);
+		}
+		else if (arg == "--samples" && has_value) {
+			samples = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (arg == "--matches" && has_value) {
+			matches = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (arg == "--bots" && has_value) {
+			bots = std::atoi(argv[++i]);
+		}
+		else if (arg == "--seed" && has_value) {
+			seed = unsigned(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--threads" && has_value) {
+			thread_count = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (arg == "--max-ticks" && has_value) {
+			max_ticks = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (arg == "--map" && has_value) {
+			map_path = argv[++i];
+		}
+		else if (arg == "--csv" && has_value) {
+			csv_path = argv[++i];
+		}
+		else if (arg == "--list") {
+			for (const Parameter& parameter : parameters) {
+				printf("%s\n", parameter.name.c_str());
+			}
+			return 0;
+		}
+		else {
+			printf("Usage: %s [--grid name=v0,v1,...]... [--random name=min:max --samples N]... [--matches N] [--bots N] [--seed N] [--threads N] [--max-ticks N] [--map path] [--csv path] [--list]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	SetTraceLogLevel(LOG_WARNING);
+
+	// Every grid combination, each one with its own random samples when there are random axes
+	std::mt19937 random_generator(seed);
+	std::vector<Config> configs;
+	std::vector<size_t> grid_index(grid_axes.size(), 0);
+
+	while (true) {
+		for (int sample = 0; sample < (random_axes.empty() ? 1 : samples); ++sample) {
+			Config config;
+			for (size_t i = 0; i < grid_axes.size(); ++i) {
+				config.values.push_back(grid_axes.at(i).values.at(grid_index.at(i)));
+				grid_axes.at(i).parameter->apply(config.settings, config.values.back());
+			}
+			for (const Axis& axis : random_axes) {
+				config.values.push_back(std::uniform_real_distribution<double>(axis.min, axis.max)(random_generator));
+				axis.parameter->apply(config.settings, config.values.back());
+			}
+			configs.push_back(std::move(config));
+		}
+
+		size_t axis = 0;
+		while (axis < grid_axes.size() && ++grid_index.at(axis) == grid_axes.at(axis).values.size()) {
+			grid_index.at(axis) = 0;
+			++axis;
+		}
+		if (axis == grid_axes.size()) {
+			break;
+		}
+	}
+
+	// Levels keep a reference to their settings, so they are loaded once the configs don't move anymore
+	for (Config& config : configs) {
+		config.level.reset(new Level(config.settings, map_path));
+	}
+
+	if (configs.front().level->playerSpawns.empty()) {
+		printf("Couldn't load %s\n", map_path.c_str());
+		return 1;
+	}
+
+	const int spawn_count = int(configs.front().level->playerSpawns.size());
+	bots = std::clamp(bots, 1, int(std::min<size_t>(spawn_count, Settings().playerTints.size())));
+
+	const size_t match_count = configs.size() * size_t(matches);
+	printf("%zu configs x %d matches on %d threads\n", configs.size(), matches, thread_count);
+
+	// Each worker plays one session at a time, taking the next match from a shared counter
+	std::vector<MatchResult> results(match_count);
+	std::atomic<size_t> next_match{ 0 };
+	std::atomic<size_t> done_matches{ 0 };
+	std::mutex progress_mutex;
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < thread_count; ++i) {
+		threads.emplace_back([&]() {
+			std::unique_ptr<Session> session;
+			for (size_t match = next_match++; match < match_count; match = next_match++) {
+				const Config& config = configs.at(match / matches);
+				const unsigned match_seed = seed * 2654435761u + unsigned(match);
+				results.at(match) = playMatch(session, config, bots, match_seed, max_ticks);
+
+				const size_t done = ++done_matches;
+				if (done % 100 == 0 || done == match_count) {
+					std::lock_guard<std::mutex> lock(progress_mutex);
+					printf("\r%zu / %zu matches", done, match_count);
+					fflush(stdout);
+				}
+			}
+		});
+	}
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	FILE* file = fopen(csv_path.c_str(), "w");
+	if (file == nullptr) {
+		printf("\nCouldn't write %s\n", csv_path.c_str());
+		return 1;
+	}
+
+	fprintf(file, "config");
+	for (const Axis& axis : grid_axes) {
+		fprintf(file, ",%s", axis.parameter->name.c_str());
+	}
+	for (const Axis& axis : random_axes) {
+		fprintf(file, ",%s", axis.parameter->name.c_str());
+	}
+	fprintf(file, ",matches,timeouts,mean_match_seconds");
+	for (int i = 0; i < spawn_count; ++i) {
+		fprintf(file, ",win_rate_spawn%d", i);
+	}
+	fprintf(file, ",kills_machinegun,kills_shotgun,kills_rocket,ticks_per_second\n");
+
+	uint64_t total_ticks = 0;
+	for (size_t i = 0; i < configs.size(); ++i) {
+		int timeouts = 0;
+		uint64_t ticks = 0;
+		double seconds = 0;
+		std::vector<int> wins(spawn_count, 0);
+		std::array<int, weaponTypeCount> kills{};
+
+		for (int j = 0; j < matches; ++j) {
+			const MatchResult& result = results.at(i * matches + j);
+			timeouts += result.finished ? 0 : 1;
+			ticks += result.ticks;
+			seconds += result.seconds;
+			if (result.finished) {
+				wins.at(result.winnerSpawn) += 1;
+			}
+			for (int k = 0; k < weaponTypeCount; ++k) {
+				kills.at(k) += result.kills.at(k);
+			}
+		}
+
+		total_ticks += ticks;
+
+		fprintf(file, "%zu", i);
+		for (const double value : configs.at(i).values) {
+			fprintf(file, ",%g", value);
+		}
+		fprintf(file, ",%d,%d,%.2f", matches, timeouts, double(ticks) / matches / configs.at(i).settings.tickRate);
+		for (const int spawn_wins : wins) {
+			fprintf(file, ",%.4f", double(spawn_wins) / matches);
+		}
+		fprintf(file, ",%d,%d,%d,%.0f\n", kills.at(WeaponType::MachineGun), kills.at(WeaponType::Shotgun), kills.at(WeaponType::RocketLauncher), seconds > 0 ? double(ticks) / seconds : 0.0);
+	}
+
+	fclose(file);
+
+	printf("\n%.1f s, %.0f ticks/s over all threads, written to %s\n", elapsed, double(total_ticks) / elapsed, csv_path.c_str());
+	return 0;
+}
@@ -0,0 +1,378 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include "actors.h"
+#include "bit_grid.h"
+#include "level.h"
+#include "weapons.h"
+
+// Procedural levels: cellular automaton caves, rooms and corridors, and caves mirrored into four symmetric quadrants.
+// Walls are destructible tiles inside a bedrock border, and spawns are spread over the area reachable by a drone.
+class LevelGenerator {
+public:
+	enum class Layout {
+		Caves,
+		Rooms,
+		Arena,
+	};
+
+	struct Options {
+		Layout layout = Layout::Caves;
+		int width = 64;
+		int height = 56;
+		unsigned seed = 0;
+		int players = 4;
+		int itemsPerWeapon = 1;
+		float wallRatio = 0.45f;
+		int smoothSteps = 4;
+	};
+
+	static constexpr int droneSize = 4;
+	static constexpr int corridorWidth = 6;
+	static constexpr int minSpawnDistance = 7; // Farther than this, two 4x4 footprints can't overlap
+
+	// Returns false if the reachable area is too small for all the spawns
+	static bool generate(const Options& options, Level& level) {
+		std::mt19937_64 random_generator(options.seed);
+		BitGrid walls(options.width, options.height, true);
+
+		if (options.layout == Layout::Caves) {
+			caves(options, random_generator, walls);
+		}
+		else if (options.layout == Layout::Rooms) {
+			rooms(options, random_generator, walls);
+		}
+		else {
+			const glm::ivec2 center(options.width / 2, options.height / 2);
+			caves(options, random_generator, walls);
+
+			// Joins the largest area of the top left quadrant to the middle before mirroring it, so that it's reachable from the other quadrants
+			BitGrid quadrant_fits = droneFits(walls);
+			for (int y = 0; y < options.height; ++y) {
+				for (int x = 0; x < options.width; ++x) {
+					if (!inQuadrant(options, glm::ivec2(x, y))) {
+						quadrant_fits.set(x, y, false);
+					}
+				}
+			}
+
+			std::vector<int> queue;
+			const std::vector<glm::ivec2> quadrant_area = largestArea(quadrant_fits, queue);
+			if (!quadrant_area.empty()) {
+				const glm::ivec2 entrance = *std::max_element(quadrant_area.begin(), quadrant_area.end(), [](const glm::ivec2& position0, const glm::ivec2& position1) {
+					return position0.x + position0.y < position1.x + position1.y;
+				});
+				walls.fill(entrance, glm::ivec2(center.x, entrance.y + corridorWidth - 1), false);
+			}
+
+			mirror(walls);
+
+			// Opens a cross through the middle so that the quadrants are connected
+			walls.fill(glm::ivec2(1, center.y - corridorWidth / 2), glm::ivec2(options.width - 2, center.y + corridorWidth / 2 - 1), false);
+			walls.fill(glm::ivec2(center.x - corridorWidth / 2, 1), glm::ivec2(center.x + corridorWidth / 2 - 1, options.height - 2), false);
+		}
+
+		walls.fill(glm::ivec2(0, 0), glm::ivec2(options.width - 1, 0), true);
+		walls.fill(glm::ivec2(0, options.height - 1), glm::ivec2(options.width - 1, options.height - 1), true);
+		walls.fill(glm::ivec2(0, 0), glm::ivec2(0, options.height - 1), true);
+		walls.fill(glm::ivec2(options.width - 1, 0), glm::ivec2(options.width - 1, options.height - 1), true);
+
+		level.resize(options.width, options.height);
+		for (int y = 0; y < options.height; ++y) {
+			for (int x = 0; x < options.width; ++x) {
+				const bool border = x == 0 || y == 0 || x == options.width - 1 || y == options.height - 1;
+				level.tile(x, y) = Level::Tile{ border, walls.get(x, y) ? level.settings.tileHealth : 0 };
+			}
+		}
+
+		return placeSpawns(options, random_generator, walls, level);
+	}
+
+	// One step of the 4-5 rule: a cell becomes a wall with 5 or more wall neighbors, and stays one with 4 or more.
+	// The 8 neighbor counts of a word are summed in bit slices, so 64 cells are updated with a few dozen operations.
+	static void smooth(const BitGrid& source, BitGrid& target) {
+		for (int y = 0; y < source.height; ++y) {
+			for (int x_word = 0; x_word < source.words; ++x_word) {
+				const std::array<uint64_t, 8> neighbors{
+					source.leftNeighbors(x_word, y - 1), source.word(x_word, y - 1), source.rightNeighbors(x_word, y - 1),
+					source.leftNeighbors(x_word, y), source.rightNeighbors(x_word, y),
+					source.leftNeighbors(x_word, y + 1), source.word(x_word, y + 1), source.rightNeighbors(x_word, y + 1),
+				};
+
+				uint64_t count0 = 0;
+				uint64_t count1 = 0;
+				uint64_t count2 = 0;
+				uint64_t count3 = 0;
+				for (const uint64_t neighbor : neighbors) {
+					const uint64_t carry0 = count0 & neighbor;
+					count0 ^= neighbor;
+					const uint64_t carry1 = count1 & carry0;
+					count1 ^= carry0;
+					const uint64_t carry2 = count2 & carry1;
+					count2 ^= carry1;
+					count3 |= carry2;
+				}
+
+				const uint64_t at_least_5 = count3 | (count2 & (count1 | count0));
+				const uint64_t exactly_4 = ~count3 & count2 & ~count1 & ~count0;
+				target.bits[size_t(y) * target.words + x_word] = at_least_5 | (source.word(x_word, y) & exactly_4);
+			}
+		}
+
+		target.restorePadding();
+	}
+
+	// 64 independent bits set with the given probability, rounded to 1/256: each random word is combined with
+	// the result so far by OR for the 1 digits of the probability and AND for the 0 digits, from the lowest one.
+	static uint64_t randomBits(std::mt19937_64& random_generator, const float probability) {
+		const int fixed_point = std::clamp(int(probability * 256.0f + 0.5f), 0, 256);
+		if (fixed_point == 256) {
+			return ~uint64_t(0);
+		}
+
+		uint64_t bits = 0;
+		for (int digit = 0; digit < 8; ++digit) {
+			const uint64_t random = random_generator();
+			bits = ((fixed_point >> digit) & 1) ? (random | bits) : (random & bits);
+		}
+		return bits;
+	}
+
+private:
+	static void caves(const Options& options, std::mt19937_64& random_generator, BitGrid& walls) {
+		for (uint64_t& word : walls.bits) {
+			word = randomBits(random_generator, options.wallRatio);
+		}
+		walls.restorePadding();
+
+		BitGrid next(walls.width, walls.height, true);
+		for (int i = 0; i < options.smoothSteps; ++i) {
+			smooth(walls, next);
+			std::swap(walls.bits, next.bits);
+		}
+	}
+
+	// Rectangular rooms that don't overlap, each one joined to the previous one by an L shaped corridor
+	static void rooms(const Options& options, std::mt19937_64& random_generator, BitGrid& walls) {
+		const int min_size = droneSize * 3;
+		const int max_size = std::max(min_size, std::min(options.width, options.height) / 4);
+		const int room_count = std::max(2, options.width * options.height / (max_size * max_size * 2));
+
+		std::uniform_int_distribution<int> random_size(min_size, max_size);
+		std::vector<std::pair<glm::ivec2, glm::ivec2>> rooms;
+
+		for (int attempt = 0; attempt < room_count * 8 && int(rooms.size()) < room_count; ++attempt) {
+			const glm::ivec2 size(random_size(random_generator), random_size(random_generator));
+			if (size.x > options.width - 4 || size.y > options.height - 4) {
+				continue;
+			}
+
+			const glm::ivec2 min(std::uniform_int_distribution<int>(2, options.width - 2 - size.x)(random_generator),
+				std::uniform_int_distribution<int>(2, options.height - 2 - size.y)(random_generator));
+			const glm::ivec2 max = min + size - glm::ivec2(1, 1);
+
+			const bool overlaps = std::any_of(rooms.begin(), rooms.end(), [&](const std::pair<glm::ivec2, glm::ivec2>& room) {
+				return min.x <= room.second.x + 2 && max.x >= room.first.x - 2 && min.y <= room.second.y + 2 && max.y >= room.first.y - 2;
+			});
+
+			if (!overlaps) {
+				rooms.emplace_back(min, max);
+			}
+		}
+
+		std::sort(rooms.begin(), rooms.end(), [](const std::pair<glm::ivec2, glm::ivec2>& room0, const std::pair<glm::ivec2, glm::ivec2>& room1) {
+			return room0.first.x + room0.first.y < room1.first.x + room1.first.y;
+		});
+
+		for (size_t i = 0; i < rooms.size(); ++i) {
+			walls.fill(rooms.at(i).first, rooms.at(i).second, false);
+
+			if (i > 0) {
+				const glm::ivec2 from = (rooms.at(i - 1).first + rooms.at(i - 1).second) / 2;
+				const glm::ivec2 to = (rooms.at(i).first + rooms.at(i).second) / 2;
+				const int half = corridorWidth / 2;
+				walls.fill(glm::ivec2(std::min(from.x, to.x) - half, from.y - half), glm::ivec2(std::max(from.x, to.x) + half, from.y + half - 1), false);
+				walls.fill(glm::ivec2(to.x - half, std::min(from.y, to.y) - half), glm::ivec2(to.x + half - 1, std::max(from.y, to.y) + half), false);
+			}
+		}
+	}
+
+	// Drone positions that don't overlap their mirrored copies
+	static bool inQuadrant(const Options& options, const glm::ivec2& position) {
+		return position.x + droneSize <= options.width / 2 && position.y + droneSize <= options.height / 2;
+	}
+
+	// Copies the top left quadrant over the other three
+	static void mirror(BitGrid& walls) {
+		for (int y = 0; y < walls.height; ++y) {
+			for (int x = 0; x < walls.width; ++x) {
+				const int source_x = x < walls.width / 2 ? x : walls.width - 1 - x;
+				const int source_y = y < walls.height / 2 ? y : walls.height - 1 - y;
+				walls.set(x, y, walls.get(source_x, source_y));
+			}
+		}
+	}
+
+	// Bit of each top left position where a drone fits without touching a wall
+	static BitGrid droneFits(const BitGrid& walls) {
+		BitGrid fits(walls.width, walls.height, false);
+
+		for (int y = 0; y < walls.height; ++y) {
+			for (int x_word = 0; x_word < walls.words; ++x_word) {
+				uint64_t rows_free = ~uint64_t(0);
+				uint64_t next_rows_free = ~uint64_t(0);
+				for (int dy = 0; dy < droneSize; ++dy) {
+					rows_free &= ~walls.word(x_word, y + dy);
+					next_rows_free &= ~walls.word(x_word + 1, y + dy);
+				}
+
+				uint64_t fit = rows_free;
+				for (int dx = 1; dx < droneSize; ++dx) {
+					fit &= (rows_free >> dx) | (next_rows_free << (64 - dx));
+				}
+				fits.bits[size_t(y) * fits.words + x_word] = fit;
+			}
+		}
+
+		fits.restorePadding();
+		return fits;
+	}
+
+	// Breadth first distances over the drone positions, only lowering the ones that are already known
+	static void relaxDistances(const BitGrid& fits, const glm::ivec2& source, std::vector<int>& distances, std::vector<int>& queue) {
+		const int width = fits.width;
+		queue.clear();
+		queue.push_back(source.y * width + source.x);
+		distances.at(queue.front()) = 0;
+
+		for (size_t head = 0; head < queue.size(); ++head) {
+			const int cell = queue.at(head);
+			const int x = cell % width;
+			const int y = cell / width;
+			const int distance = distances.at(cell) + 1;
+
+			const std::array<glm::ivec2, 4> neighbors{ glm::ivec2(x - 1, y), glm::ivec2(x + 1, y), glm::ivec2(x, y - 1), glm::ivec2(x, y + 1) };
+			for (const glm::ivec2& neighbor : neighbors) {
+				const int neighbor_cell = neighbor.y * width + neighbor.x;
+				if (fits.get(neighbor.x, neighbor.y) && (distances.at(neighbor_cell) < 0 || distances.at(neighbor_cell) > distance)) {
+					distances.at(neighbor_cell) = distance;
+					queue.push_back(neighbor_cell);
+				}
+			}
+		}
+	}
+
+	// Drone positions of the largest area connected by moves of one cell
+	static std::vector<glm::ivec2> largestArea(const BitGrid& fits, std::vector<int>& queue) {
+		std::vector<int> labels(size_t(fits.width) * fits.height, -1);
+		std::vector<glm::ivec2> largest;
+		std::vector<glm::ivec2> area;
+
+		for (int y = 0; y < fits.height; ++y) {
+			for (int x = 0; x < fits.width; ++x) {
+				if (!fits.get(x, y) || labels.at(size_t(y) * fits.width + x) >= 0) {
+					continue;
+				}
+
+				area.clear();
+				relaxDistances(fits, glm::ivec2(x, y), labels, queue);
+				for (const int cell : queue) {
+					area.push_back(glm::ivec2(cell % fits.width, cell / fits.width));
+				}
+
+				if (area.size() > largest.size()) {
+					std::swap(area, largest);
+				}
+			}
+		}
+
+		return largest;
+	}
+
+	// Farthest point sampling over the reachable area: each spawn goes where the nearest spawn already placed is the farthest.
+	// Arenas place spawns in the top left quadrant and mirror them, so each player gets the same distances.
+	static bool placeSpawns(const Options& options, std::mt19937_64& random_generator, const BitGrid& walls, Level& level) {
+		const BitGrid fits = droneFits(walls);
+		std::vector<int> queue;
+		const std::vector<glm::ivec2> area = largestArea(fits, queue);
+		if (area.empty()) {
+			return false;
+		}
+
+		const bool symmetric = options.layout == Layout::Arena;
+		std::vector<int> distances(size_t(fits.width) * fits.height, -1);
+
+		auto place = [&](const glm::ivec2& position) {
+			std::vector<glm::ivec2> positions{ position };
+			if (symmetric) {
+				const glm::ivec2 mirrored(options.width - droneSize - position.x, options.height - droneSize - position.y);
+				positions.push_back(glm::ivec2(mirrored.x, position.y));
+				positions.push_back(glm::ivec2(position.x, mirrored.y));
+				positions.push_back(mirrored);
+			}
+
+			for (const glm::ivec2& mirror_position : positions) {
+				relaxDistances(fits, mirror_position, distances, queue);
+			}
+			return positions;
+		};
+
+		auto farthest = [&]() -> std::optional<glm::ivec2> {
+			std::optional<glm::ivec2> best;
+			int best_distance = minSpawnDistance - 1;
+			for (const glm::ivec2& position : area) {
+				if (symmetric && !inQuadrant(options, position)) {
+					continue;
+				}
+
+				const int distance = distances.at(size_t(position.y) * fits.width + position.x);
+				if (distance < 0 || distance > best_distance) {
+					best = position;
+					best_distance = distance < 0 ? INT32_MAX : distance;
+				}
+			}
+			return best;
+		};
+
+		// The first spawn is the farthest position from a random one
+		relaxDistances(fits, area.at(std::uniform_int_distribution<size_t>(0, area.size() - 1)(random_generator)), distances, queue);
+
+		const int player_placements = symmetric ? 1 : options.players;
+		for (int i = 0; i < player_placements; ++i) {
+			const std::optional<glm::ivec2> position = farthest();
+			if (i == 0) {
+				std::fill(distances.begin(), distances.end(), -1);
+			}
+			if (!position.has_value()) {
+				return false;
+			}
+
+			for (const glm::ivec2& spawn : place(*position)) {
+				if (int(level.playerSpawns.size()) < options.players) {
+					level.playerSpawns.push_back(spawn);
+				}
+			}
+		}
+
+		for (int i = 0; i < options.itemsPerWeapon; ++i) {
+			for (int weapon = 0; weapon < weaponTypeCount; ++weapon) {
+				const std::optional<glm::ivec2> position = farthest();
+				if (!position.has_value()) {
+					return false;
+				}
+
+				for (const glm::ivec2& spawn : place(*position)) {
+					level.itemSpawns.push_back(Level::ItemSpawn{ spawn, ItemType(ItemType::Weapon0 + weapon) });
+				}
+			}
+		}
+
+		return true;
+	}
+};
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <glm/glm.hpp>
+#include "profiler.h"
+#include "settings.h"
+
+// Grids shared by all the bots and rebuilt once per tick, at one cell per drone sized block of tiles:
+// - danger: where projectiles are going to be soon, blurred by the blast radius
+// - line of fire: what each armed drone can shoot at
+// - attraction: how close the items are
+// Danger and line of fire keep one channel per player in a vec4, so a bot can leave out its own projectiles and aim,
+// and the blur passes run on the four channels at once. Blurs are separable box filters with running sums,
+// so their cost doesn't depend on the radius.
+class InfluenceMap {
+public:
+	static constexpr int cellSize = 4;
+
+	int width;
+	int height;
+
+	std::vector<glm::vec4> danger;
+	std::vector<glm::vec4> lineOfFire;
+	std::vector<float> attraction;
+
+	InfluenceMap(const int level_width, const int level_height) :
+		width((level_width + cellSize - 1) / cellSize), height((level_height + cellSize - 1) / cellSize) {
+		const size_t cells = size_t(width) * height;
+		danger.resize(cells);
+		lineOfFire.resize(cells);
+		attraction.resize(cells);
+		dangerSources.resize(cells);
+		lineOfFireSources.resize(cells);
+		attractionSources.resize(cells);
+		scratch.resize(cells);
+		attractionScratch.resize(cells);
+		columnSums.resize(width);
+		attractionColumnSums.resize(width);
+	}
+
+	void clear() {
+		std::fill(dangerSources.begin(), dangerSources.end(), glm::vec4(0));
+		std::fill(danger.begin(), danger.end(), glm::vec4(0));
+		std::fill(lineOfFire.begin(), lineOfFire.end(), glm::vec4(0));
+		std::fill(attraction.begin(), attraction.end(), 0.0f);
+	}
+
+	// Danger fades out over time instead of disappearing with the projectile, line of fire and attraction are rebuilt
+	void beginTick(const float danger_decay) {
+		for (glm::vec4& source : dangerSources) {
+			source *= danger_decay;
+		}
+		std::fill(lineOfFireSources.begin(), lineOfFireSources.end(), glm::vec4(0));
+		std::fill(attractionSources.begin(), attractionSources.end(), 0.0f);
+	}
+
+	// Keeps the highest danger rather than the sum, so a projectile seen again each tick doesn't build up
+	void addDanger(const glm::ivec2& tile, const int owner, const float amount) {
+		if (const int cell = cellIndex(tile); cell >= 0) {
+			dangerSources[cell][owner] = std::max(dangerSources[cell][owner], amount);
+		}
+	}
+
+	// Spreads the danger of a blast over the cells its radius covers
+	void addBlast(const glm::ivec2& tile, const int owner, const int radius, const float amount) {
+		const int cell_radius = (radius + cellSize - 1) / cellSize;
+		for (int dy = -cell_radius; dy <= cell_radius; ++dy) {
+			for (int dx = -cell_radius; dx <= cell_radius; ++dx) {
+				if (dx * dx + dy * dy <= cell_radius * cell_radius) {
+					addDanger(tile + glm::ivec2(dx, dy) * cellSize, owner, amount);
+				}
+			}
+		}
+	}
+
+	void addLineOfFire(const glm::ivec2& tile, const int owner, const float amount) {
+		if (const int cell = cellIndex(tile); cell >= 0) {
+			lineOfFireSources[cell][owner] += amount;
+		}
+	}
+
+	void addAttraction(const glm::ivec2& tile, const float amount) {
+		if (const int cell = cellIndex(tile); cell >= 0) {
+			attractionSources[cell] += amount;
+		}
+	}
+
+	void endTick(const int danger_radius, const int line_of_fire_radius, const int attraction_radius) {
+		PROFILE_SCOPE("InfluenceMap::blur");
+
+		boxBlur(dangerSources, danger, scratch, columnSums, danger_radius);
+		boxBlur(lineOfFireSources, lineOfFire, scratch, columnSums, line_of_fire_radius);
+
+		// Twice for a smoother, tent shaped falloff around the items
+		boxBlur(attractionSources, attraction, attractionScratch, attractionColumnSums, attraction_radius);
+		boxBlur(attraction, attraction, attractionScratch, attractionColumnSums, attraction_radius);
+	}
+
+	// Sum over the players other than player_index
+	float dangerAt(const glm::ivec2& tile, const int player_index) const {
+		return sampleOthers(danger, tile, player_index);
+	}
+
+	float lineOfFireAt(const glm::ivec2& tile, const int player_index) const {
+		return sampleOthers(lineOfFire, tile, player_index);
+	}
+
+	float attractionAt(const glm::ivec2& tile) const {
+		const int cell = cellIndex(tile);
+		return cell >= 0 ? attraction[cell] : 0.0f;
+	}
+
+private:
+	std::vector<glm::vec4> dangerSources;
+	std::vector<glm::vec4> lineOfFireSources;
+	std::vector<float> attractionSources;
+	std::vector<glm::vec4> scratch;
+	std::vector<float> attractionScratch;
+	std::vector<glm::vec4> columnSums;
+	std::vector<float> attractionColumnSums;
+
+	// -1 outside of the grid
+	int cellIndex(const glm::ivec2& tile) const {
+		if (tile.x < 0 || tile.y < 0) {
+			return -1;
+		}
+
+		const int x = tile.x / cellSize;
+		const int y = tile.y / cellSize;
+		return x < width && y < height ? y * width + x : -1;
+	}
+
+	float sampleOthers(const std::vector<glm::vec4>& grid, const glm::ivec2& tile, const int player_index) const {
+		const int cell = cellIndex(tile);
+		if (cell < 0) {
+			return 0.0f;
+		}
+
+		glm::vec4 others(1.0f);
+		if (player_index >= 0 && player_index < Settings::maxPlayers) {
+			others[player_index] = 0.0f;
+		}
+		return glm::dot(grid[cell], others);
+	}
+
+	// Box filter of the given radius in cells, zero outside of the grid. Rows first with a running sum along each row,
+	// then columns with running sums for a whole row at a time, so both passes stream through memory in order.
+	// input and output can be the same grid.
+	template<typename T>
+	void boxBlur(const std::vector<T>& input, std::vector<T>& output, std::vector<T>& rows, std::vector<T>& sums, const int radius) const {
+		const float scale = 1.0f / float(2 * radius + 1);
+
+		for (int y = 0; y < height; ++y) {
+			const T* in = input.data() + size_t(y) * width;
+			T* out = rows.data() + size_t(y) * width;
+
+			T sum(0);
+			for (int x = 0; x <= std::min(radius, width - 1); ++x) {
+				sum += in[x];
+			}
+
+			for (int x = 0; x < width; ++x) {
+				out[x] = sum * scale;
+				if (x + radius + 1 < width) {
+					sum += in[x + radius + 1];
+				}
+				if (x - radius >= 0) {
+					sum -= in[x - radius];
+				}
+			}
+		}
+
+		std::fill(sums.begin(), sums.end(), T(0));
+		for (int y = 0; y <= std::min(radius, height - 1); ++y) {
+			const T* row = rows.data() + size_t(y) * width;
+			for (int x = 0; x < width; ++x) {
+				sums[x] += row[x];
+			}
+		}
+
+		for (int y = 0; y < height; ++y) {
+			T* out = output.data() + size_t(y) * width;
+			for (int x = 0; x < width; ++x) {
+				out[x] = sums[x] * scale;
+			}
+
+			if (y + radius + 1 < height) {
+				const T* added = rows.data() + size_t(y + radius + 1) * width;
+				for (int x = 0; x < width; ++x) {
+					sums[x] += added[x];
+				}
+			}
+
+			if (y - radius >= 0) {
+				const T* removed = rows.data() + size_t(y - radius) * width;
+				for (int x = 0; x < width; ++x) {
+					sums[x] -= removed[x];
+				}
+			}
+		}
+	}
+};
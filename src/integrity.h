@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "level.h"
+#include "profiler.h"
+
+// Finds the solid tiles that lost their connection to bedrock and collapses them. Only the neighbors of the tiles
+// destroyed in a tick can have been cut off, so each of them is re-flooded through the solid tiles: a flood that
+// reaches bedrock stops there, one that runs out of tiles is a floating region. Floods go towards the nearest bedrock
+// first, guided by a distance field that never changes since bedrock can't be destroyed, so checking a tile that is
+// still anchored costs about its distance to bedrock, and a floating region costs its size, not the size of the map.
+// Tiles reached by a flood keep its result for the rest of the tick, so later floods stop when they touch them.
+class StructuralIntegrity {
+public:
+	StructuralIntegrity(const Level& level) {
+		reset(level);
+	}
+
+	// Computes the distance field of the level. Everything stays up in levels without bedrock.
+	void reset(const Level& level) {
+		width = level.width;
+		height = level.height;
+
+		const size_t tile_count = size_t(width) * height;
+		bedrockDistances.assign(tile_count, UINT16_MAX);
+		visitedPass.assign(tile_count, 0);
+		anchoredPass.assign(tile_count, 0);
+		heap.clear();
+		heap.reserve(tile_count);
+		region.clear();
+		region.reserve(tile_count);
+		pass = 0;
+
+		// Breadth first from every bedrock tile, through any tile, with the region vector as the queue
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				if (level.tile(x, y).bedrock) {
+					bedrockDistances[index(x, y)] = 0;
+					region.push_back(index(x, y));
+				}
+			}
+		}
+
+		hasBedrock = !region.empty();
+
+		for (size_t i = 0; i < region.size(); ++i) {
+			const uint32_t tile = region[i];
+			const int x = int(tile % uint32_t(width));
+			const int y = int(tile / uint32_t(width));
+			const uint16_t distance = uint16_t(std::min(bedrockDistances[tile] + 1, int(UINT16_MAX)));
+
+			for (int n = 0; n < 4; ++n) {
+				const int nx = x + neighborsX[n];
+				const int ny = y + neighborsY[n];
+				if (nx >= 0 && ny >= 0 && nx < width && ny < height && bedrockDistances[index(nx, ny)] == UINT16_MAX) {
+					bedrockDistances[index(nx, ny)] = distance;
+					region.push_back(index(nx, ny));
+				}
+			}
+		}
+
+		region.clear();
+	}
+
+	// Checks the neighbors of destroyed_tiles[first, end), and destroys the floating regions, appending their tiles
+	// to destroyed_tiles. Returns the number of collapsed tiles.
+	size_t collapse(Level& level, std::vector<glm::ivec2>& destroyed_tiles, const size_t first) {
+		PROFILE_SCOPE("StructuralIntegrity::collapse");
+
+		if (!hasBedrock || level.width != width || level.height != height) {
+			return 0;
+		}
+
+		++pass;
+		const size_t end = destroyed_tiles.size();
+		size_t collapsed = 0;
+
+		for (size_t i = first; i < end; ++i) {
+			const glm::ivec2 destroyed = destroyed_tiles[i];
+
+			for (int n = 0; n < 4; ++n) {
+				const glm::ivec2 seed = destroyed + glm::ivec2(neighborsX[n], neighborsY[n]);
+				if (!isSolid(level, seed.x, seed.y) || visitedPass[index(seed.x, seed.y)] == pass) {
+					continue;
+				}
+
+				if (!flood(level, seed)) {
+					for (const uint32_t tile : region) {
+						const int x = int(tile % uint32_t(width));
+						const int y = int(tile / uint32_t(width));
+						level.tile(x, y).solidity = 0;
+						destroyed_tiles.push_back(glm::ivec2(x, y));
+					}
+					collapsed += region.size();
+				}
+			}
+		}
+
+		if (collapsed > 0) {
+			level.textureDirty = true;
+		}
+
+		return collapsed;
+	}
+
+private:
+	static constexpr int neighborsX[4] = { 1, -1, 0, 0 };
+	static constexpr int neighborsY[4] = { 0, 0, 1, -1 };
+
+	int width = 0;
+	int height = 0;
+	bool hasBedrock = false;
+	uint32_t pass = 0;
+
+	std::vector<uint16_t> bedrockDistances;
+	std::vector<uint32_t> visitedPass; // Pass in which a flood last reached the tile
+	std::vector<uint32_t> anchoredPass; // Pass in which the tile was found connected to bedrock
+	std::vector<uint64_t> heap; // Min heap of bedrock distance << 32 | tile index
+	std::vector<uint32_t> region; // Tiles reached by the current flood
+
+	uint32_t index(const int x, const int y) const {
+		return uint32_t(y) * uint32_t(width) + uint32_t(x);
+	}
+
+	bool isSolid(const Level& level, const int x, const int y) const {
+		return x >= 0 && y >= 0 && x < width && y < height && level.tile(x, y).solidity > 0;
+	}
+
+	// Returns true if the seed is connected to bedrock, region has the tiles reached either way
+	bool flood(const Level& level, const glm::ivec2& seed) {
+		heap.clear();
+		region.clear();
+
+		const auto push = [this](const uint32_t tile) {
+			visitedPass[tile] = pass;
+			heap.push_back(uint64_t(bedrockDistances[tile]) << 32 | tile);
+			std::push_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+		};
+
+		push(index(seed.x, seed.y));
+
+		bool anchored = false;
+		while (!heap.empty() && !anchored) {
+			std::pop_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+			const uint32_t tile = uint32_t(heap.back());
+			heap.pop_back();
+			region.push_back(tile);
+
+			const int x = int(tile % uint32_t(width));
+			const int y = int(tile / uint32_t(width));
+			if (level.tile(x, y).bedrock || anchoredPass[tile] == pass) {
+				anchored = true;
+				break;
+			}
+
+			for (int n = 0; n < 4; ++n) {
+				const int nx = x + neighborsX[n];
+				const int ny = y + neighborsY[n];
+				if (!isSolid(level, nx, ny)) {
+					continue;
+				}
+
+				const uint32_t neighbor = index(nx, ny);
+				if (anchoredPass[neighbor] == pass) {
+					anchored = true;
+					break;
+				}
+
+				if (visitedPass[neighbor] != pass) {
+					push(neighbor);
+				}
+			}
+		}
+
+		if (anchored) {
+			// Everything reached is connected to the anchor through the flood, and so is everything still queued
+			for (const uint32_t tile : region) {
+				anchoredPass[tile] = pass;
+			}
+			for (const uint64_t entry : heap) {
+				anchoredPass[uint32_t(entry)] = pass;
+			}
+		}
+
+		return anchored;
+	}
+};
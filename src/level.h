@@ -0,0 +1,322 @@
+#pragma once
+
+#include <raylib.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "settings.h"
+#include "actors.h"
+#include "embedded_map.h"
+
+class Level {
+public:
+	struct Tile
+	{
+		bool bedrock;
+		float solidity;
+	};
+
+	struct ItemSpawn
+	{
+		glm::ivec2 position;
+		ItemType type;
+	};
+
+	const Settings& settings;
+	int width = 0;
+	int height = 0;
+	std::vector<Tile> tiles; // Row major, width * height, see tile() and row()
+	std::vector<glm::ivec2> playerSpawns;
+	std::vector<ItemSpawn> itemSpawns;
+
+	using Pixels = std::vector<glm::u8vec4>; // Row major, width * height
+
+	// Created on the first refresh, so that levels can be used without a window
+	Texture texture{};
+	bool textureDirty = true;
+
+	Level(const Settings& _settings, const std::filesystem::path& path) : settings(_settings) {
+		//testLevel();
+		loadLevel(path);
+	}
+
+	// Built-in level, already parsed and checked by the compiler
+	Level(const Settings& _settings, const EmbeddedMaps::View& map) : settings(_settings) {
+		resize(map.width, map.height);
+
+		for (int i = 0; i < height; ++i) {
+			for (int j = 0; j < width; ++j) {
+				const int8_t value = map.tiles[size_t(i) * width + j];
+				tile(j, i) = Tile{ value == 1, value >= 0 ? settings.tileHealth : 0 };
+			}
+		}
+
+		for (int i = 0; i < map.spawnCount; ++i) {
+			const EmbeddedMaps::Spawn& spawn = map.spawns[i];
+			if (spawn.type == 2) {
+				playerSpawns.push_back(glm::ivec2(spawn.x, spawn.y));
+			}
+			else {
+				itemSpawns.push_back(ItemSpawn{ glm::ivec2(spawn.x, spawn.y), ItemType(ItemType::Weapon0 + (spawn.type - 4)) });
+			}
+		}
+	}
+
+	// Level without any tile, to be filled by a generator
+	Level(const Settings& _settings, const int _width, const int _height) : settings(_settings) {
+		resize(_width, _height);
+	}
+
+	// Copies don't share the texture, each one creates its own when it's first drawn
+	Level(const Level& other) : settings(other.settings), width(other.width), height(other.height), tiles(other.tiles),
+		playerSpawns(other.playerSpawns), itemSpawns(other.itemSpawns) {
+	}
+
+	Level& operator=(const Level&) = delete;
+
+	~Level() {
+		if (texture.id != 0) {
+			UnloadTexture(texture);
+		}
+	}
+
+	Tile& tile(const int x, const int y) {
+		return tiles[size_t(y) * width + x];
+	}
+
+	const Tile& tile(const int x, const int y) const {
+		return tiles[size_t(y) * width + x];
+	}
+
+	// The width tiles of a row
+	Tile* row(const int y) {
+		return tiles.data() + size_t(y) * width;
+	}
+
+	const Tile* row(const int y) const {
+		return tiles.data() + size_t(y) * width;
+	}
+
+	void refreshTexture() {
+		if (texture.id == 0) {
+			Image dummy_image = GenImageColor(width, height, BLACK);
+			texture = LoadTextureFromImage(dummy_image);
+			UnloadImage(dummy_image);
+		}
+
+		Pixels pixels;
+		buildPixels(pixels);
+		UpdateTexture(texture, pixels.data());
+	}
+
+	void buildPixels(Pixels& pixels) const {
+		pixels.resize(size_t(width) * height);
+		for (size_t i = 0; i < tiles.size(); ++i) {
+			pixels[i] = tiles[i].solidity > 0 ? glm::u8vec4(255, 255, 255, 255) : glm::u8vec4(0, 0, 0, 255);
+		}
+	}
+
+	// Damages the non-bedrock tiles in [x_min, x_max] of a row, adds the ones it destroys to destroyed_tiles and returns true if there are any
+	bool damageRow(const int y, const int x_min, const int x_max, const float damage, std::vector<glm::ivec2>& destroyed_tiles) {
+		Tile* const tiles_row = row(y);
+		const size_t destroyed_before = destroyed_tiles.size();
+
+		for (int x = x_min; x <= x_max; ++x) {
+			Tile& tile = tiles_row[x];
+			const bool solid = tile.solidity > 0;
+			tile.solidity -= tile.bedrock ? 0.0f : damage;
+			if (solid && tile.solidity <= 0) {
+				destroyed_tiles.push_back(glm::ivec2(x, y));
+			}
+		}
+
+		return destroyed_tiles.size() > destroyed_before;
+	}
+
+	// Puts back the tiles of the level this one was copied from. Levels of the same size reuse the tile storage and the texture.
+	void restore(const Level& source) {
+		if (source.width != width || source.height != height) {
+			if (texture.id != 0) {
+				UnloadTexture(texture);
+				texture = Texture{};
+			}
+			width = source.width;
+			height = source.height;
+			tiles = source.tiles;
+		}
+		else {
+			std::copy(source.tiles.begin(), source.tiles.end(), tiles.begin());
+		}
+
+		playerSpawns = source.playerSpawns;
+		itemSpawns = source.itemSpawns;
+		textureDirty = true;
+	}
+
+	void resize(const int _width, const int _height) {
+		width = _width;
+		height = _height;
+		tiles.assign(size_t(width) * height, Tile{ false, 0 });
+		playerSpawns.clear();
+		itemSpawns.clear();
+	}
+
+	// The size of the level is the number of rows and the number of values in the first row
+	void loadLevel(const std::filesystem::path& path) {
+		std::ifstream stream(path);
+
+		std::vector<std::string> lines;
+		std::string line;
+		while (std::getline(stream, line)) {
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			if (!line.empty()) {
+				lines.push_back(line);
+			}
+		}
+
+		resize(lines.empty() ? 0 : int(std::count(lines.front().begin(), lines.front().end(), ',')) + 1, int(lines.size()));
+
+		for (int i = 0; i < height; ++i) {
+			const std::string& line = lines.at(i);
+			int j = 0;
+
+			auto token_start = line.begin();
+			for (auto iter = std::next(line.begin()); j < width; ++iter) {
+				if (iter == line.end() || *iter == ',') {
+					const std::string token(token_start, iter);
+					const int value = std::stoi(token);
+
+					if (value == 0) {
+						tile(j, i) = Tile{ false, settings.tileHealth };
+					}
+					else if (value == 1) {
+						tile(j, i) = Tile{ true, settings.tileHealth };
+					}
+					else if (value == 2) {
+						playerSpawns.push_back(glm::ivec2(j, i));
+					}
+					else if (value == 4) {
+						itemSpawns.push_back(ItemSpawn{ glm::ivec2(j, i), ItemType::Weapon0 });
+					}
+					else if (value == 5) {
+						itemSpawns.push_back(ItemSpawn{ glm::ivec2(j, i), ItemType::Weapon1 });
+					}
+					else if (value == 6) {
+						itemSpawns.push_back(ItemSpawn{ glm::ivec2(j, i), ItemType::Weapon2 });
+					}
+
+					++j;
+					if (iter == line.end()) {
+						break;
+					}
+					else {
+						token_start = std::next(iter);
+					}
+				}
+			}
+		}
+	}
+
+	// Writes the level in the encoding read by loadLevel: -1 empty, 0 solid, 1 bedrock, 2 player spawn, 4-6 weapon spawns
+	bool saveLevel(const std::filesystem::path& path) const {
+		std::vector< std::vector<int> > values(height, std::vector<int>(width, -1));
+		for (int i = 0; i < height; ++i) {
+			for (int j = 0; j < width; ++j) {
+				if (tile(j, i).bedrock) {
+					values.at(i).at(j) = 1;
+				}
+				else if (tile(j, i).solidity > 0) {
+					values.at(i).at(j) = 0;
+				}
+			}
+		}
+
+		for (const glm::ivec2& spawn : playerSpawns) {
+			values.at(spawn.y).at(spawn.x) = 2;
+		}
+
+		for (const ItemSpawn& spawn : itemSpawns) {
+			values.at(spawn.position.y).at(spawn.position.x) = 4 + (spawn.type - ItemType::Weapon0);
+		}
+
+		FILE* file = fopen(path.string().c_str(), "w");
+		if (file == nullptr) {
+			return false;
+		}
+
+		for (const std::vector<int>& row : values) {
+			for (int j = 0; j < width; ++j) {
+				fprintf(file, j == 0 ? "%d" : ",%d", row.at(j));
+			}
+			fprintf(file, "\n");
+		}
+
+		fclose(file);
+		return true;
+	}
+
+private:
+	void testLevel() {
+		resize(64, 56);
+
+		for (int i = 0; i < height; ++i) {
+			for (int j = 0; j < width; ++j) {
+				const bool bedrock = (i == 0 || i == height - 1 || j == 0 || j == width - 1);
+				tile(j, i) = Tile{ bedrock, bedrock ? settings.tileHealth : 0 };
+			}
+		}
+
+		for (int i = 20; i < 40; ++i) {
+			for (int j = 20; j < 40; ++j) {
+				tile(j, i) = Tile{ false, 1 };
+			}
+		}
+
+		playerSpawns.clear();
+		playerSpawns.push_back(glm::ivec2(2, 2));
+		playerSpawns.push_back(glm::ivec2(58, 2));
+		playerSpawns.push_back(glm::ivec2(2, 50));
+		playerSpawns.push_back(glm::ivec2(58, 50));
+
+		itemSpawns.clear();
+		itemSpawns.push_back(ItemSpawn{ glm::ivec2(10, 2), ItemType::Weapon0 });
+		itemSpawns.push_back(ItemSpawn{ glm::ivec2(9, 19), ItemType::Weapon1 });
+		itemSpawns.push_back(ItemSpawn{ glm::ivec2(49, 21), ItemType::Weapon2 });
+	}
+};
+
+// Levels parsed once per file and never modified, sessions work on copies of them. Built-in maps are used instead of
+// the files of the same name, without reading them.
+class LevelCache {
+public:
+	LevelCache(const Settings& _settings, const std::vector<EmbeddedMaps::View>& _builtIn = {}) : settings(_settings), builtIn(_builtIn) {
+	}
+
+	std::shared_ptr<const Level> get(const std::filesystem::path& path) {
+		const std::string name = path.lexically_normal().string();
+		std::shared_ptr<const Level>& level = levels[name];
+		if (!level) {
+			const auto map = std::find_if(builtIn.begin(), builtIn.end(), [&name](const EmbeddedMaps::View& view) { return name == view.name; });
+			if (map != builtIn.end()) {
+				level = std::make_shared<const Level>(settings, *map);
+			}
+			else {
+				level = std::make_shared<const Level>(settings, path);
+			}
+		}
+		return level;
+	}
+
+private:
+	const Settings& settings;
+	std::vector<EmbeddedMaps::View> builtIn;
+	std::unordered_map<std::string, std::shared_ptr<const Level>> levels;
+};
@@ -0,0 +1,102 @@
+#include <raylib.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "settings.h"
+#include "level.h"
+#include "generator.h"
+
+// Writes procedurally generated levels in the CSV format of map0.csv:
+// destructive_drones_mapgen [--layout caves|rooms|arena] [--width N] [--height N] [--seed N] [--count N] [--players N]
+//                           [--items-per-weapon N] [--wall-ratio R] [--smooth-steps N] [--output prefix]
+// Writes prefix0.csv, prefix1.csv... with consecutive seeds.
+int main(int argc, char** argv) {
+	LevelGenerator::Options options;
+	std::string output = "generated";
+	int count = 1;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		const bool has_value = i + 1 < argc;
+
+		if (arg == "--layout" && has_value) {
+			const std::string layout = argv[++i];
+			if (layout == "caves") {
+				options.layout = LevelGenerator::Layout::Caves;
+			}
+			else if (layout == "rooms") {
+				options.layout = LevelGenerator::Layout::Rooms;
+			}
+			else if (layout == "arena") {
+				options.layout = LevelGenerator::Layout::Arena;
+			}
+			else {
+				printf("Unknown layout %s\n", layout.c_str());
+				return 1;
+			}
+		}
+		else if (arg == "--width" && has_value) {
+			options.width = std::atoi(argv[++i]);
+		}
+		else if (arg == "--height" && has_value) {
+			options.height = std::atoi(argv[++i]);
+		}
+		else if (arg == "--seed" && has_value) {
+			options.seed = unsigned(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--count" && has_value) {
+			count = std::atoi(argv[++i]);
+		}
+		else if (arg == "--players" && has_value) {
+			options.players = std::atoi(argv[++i]);
+		}
+		else if (arg == "--items-per-weapon" && has_value) {
+			options.itemsPerWeapon = std::atoi(argv[++i]);
+		}
+		else if (arg == "--wall-ratio" && has_value) {
+			options.wallRatio = float(std::atof(argv[++i]));
+		}
+		else if (arg == "--smooth-steps" && has_value) {
+			options.smoothSteps = std::atoi(argv[++i]);
+		}
+		else if (arg == "--output" && has_value) {
+			output = argv[++i];
+		}
+		else {
+			printf("Usage: %s [--layout caves|rooms|arena] [--width N] [--height N] [--seed N] [--count N] [--players N] [--items-per-weapon N] [--wall-ratio R] [--smooth-steps N] [--output prefix]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (options.width < 16 || options.height < 16) {
+		printf("Levels must be at least 16x16\n");
+		return 1;
+	}
+
+	SetTraceLogLevel(LOG_WARNING);
+
+	const Settings settings;
+	Level level(settings, options.width, options.height);
+	int failures = 0;
+
+	for (int i = 0; i < count; ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		const bool placed = LevelGenerator::generate(options, level);
+		const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		const std::string path = output + std::to_string(i) + ".csv";
+		if (!level.saveLevel(path)) {
+			printf("Couldn't write %s\n", path.c_str());
+			return 1;
+		}
+
+		printf("%s: seed %u, %dx%d, %zu player spawns, %zu item spawns, %.2f ms%s\n", path.c_str(), options.seed, level.width, level.height,
+			level.playerSpawns.size(), level.itemSpawns.size(), milliseconds, placed ? "" : " (not enough room for all the spawns)");
+
+		failures += placed ? 0 : 1;
+		++options.seed;
+	}
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <raylib.h>
+#include <algorithm>
+#include <vector>
+#include <glm/glm.hpp>
+#include "settings.h"
+#include "content.h"
+#include "profiler.h"
+
+class Menu {
+public:
+
+	enum MenuPage {
+		Splash,
+		SelectPlayers,
+		Help1,
+		Help2,
+		Help3,
+		Credits,
+		GameStarting,
+		Rankings,
+		Rematch,
+	};
+
+	const Settings& settings;
+	Content& content;
+	const Camera2D& camera;
+	MenuPage currentPage;
+	int players = 1;
+	int bots = 3;
+	std::vector<int> rankings;
+
+	Menu(const Settings& _settings, Content& _content, const Camera2D& _camera) : settings(_settings), content(_content), camera(_camera), currentPage(MenuPage::Splash) {
+	}
+
+	Menu(const Settings& _settings, Content& _content, const Camera2D& _camera, const std::vector<int>& _rankings) : settings(_settings), content(_content), camera(_camera), currentPage(MenuPage::Rankings), rankings(_rankings) {
+	}
+
+	void updateAndRender()
+	{
+		PROFILE_SCOPE("Menu::updateAndRender");
+
+		if (content.menuVideoFrames() > 0) {
+			const int frame = int(GetTime() * 30) % content.menuVideoFrames();
+			DrawTexture(content.menuVideoFrame(frame), 0, 0, Color{ 170, 170, 170, 255 });
+		}
+
+		if (currentPage == MenuPage::Splash) {
+			DrawTexture(content.splash, 0, 0, WHITE);
+
+			if (button(content.button_credits, 54, 34)) {
+				currentPage = MenuPage::Credits;
+			}
+
+			if (button(content.button_help, 54, 44)) {
+				currentPage = MenuPage::Help1;
+			}
+
+			if (button(content.button_play, 54, 54)) {
+				currentPage = MenuPage::SelectPlayers;
+			}
+		}
+		else if (currentPage == MenuPage::Help1) {
+			DrawTexture(content.help1, 0, 0, WHITE);
+
+			if (button(content.button_play, 1, 54)) {
+				currentPage = MenuPage::Help2;
+			}
+		}
+		else if (currentPage == MenuPage::Help2) {
+			DrawTexture(content.help2, 0, 0, WHITE);
+
+			if (button(content.button_play, 1, 54)) {
+				currentPage = MenuPage::Help3;
+			}
+		}
+		else if (currentPage == MenuPage::Help3) {
+			DrawTexture(content.help3, 0, 0, WHITE);
+
+			if (button(content.button_play, 1, 54)) {
+				currentPage = MenuPage::Splash;
+			}
+		}
+		else if (currentPage == MenuPage::Credits) {
+			DrawTexture(content.credits, 0, 0, WHITE);
+
+			if (button(content.button_back, 54, 54)) {
+				currentPage = MenuPage::Splash;
+			}
+		}
+		else if (currentPage == MenuPage::SelectPlayers) {
+			DrawTexture(content.select_players, 0, 0, WHITE);
+
+			{
+				if (button(content.button_one, 7, 15, players == 1)) {
+					players = 1;
+				}
+
+				if (button(content.button_two, 21, 15, players == 2)) {
+					players = 2;
+				}
+
+				if (button(content.button_three, 35, 15, players == 3)) {
+					players = 3;
+				}
+
+				if (button(content.button_four, 49, 15, players == 4)) {
+					players = 4;
+				}
+			}
+
+			{
+				if (button(content.button_zero, 7, 41, bots == 0)) {
+					bots = 0;
+				}
+
+				if (button(content.button_one, 21, 41, bots == 1)) {
+					bots = 1;
+				}
+
+				if (button(content.button_two, 35, 41, bots == 2)) {
+					bots = 2;
+				}
+
+				if (button(content.button_three, 49, 41, bots == 3)) {
+					bots = 3;
+				}
+			}
+
+			bots = std::clamp(bots, 0, 4 - players);
+
+			if (button(content.button_back, 1, 54)) {
+				currentPage = MenuPage::Splash;
+			}
+
+			if (button(content.button_play, 54, 54)) {
+				currentPage = MenuPage::GameStarting;
+			}
+		}
+		else if (currentPage == MenuPage::Rankings) {
+			DrawTexture(content.rankings, 0, 0, WHITE);
+
+			if (rankings.size() >= 1) {
+				DrawTexture(content.drone, 36, 23, settings.playerTints.at(rankings.at(0)));
+			}
+
+			if (rankings.size() >= 2) {
+				DrawTexture(content.drone, 36, 31, settings.playerTints.at(rankings.at(1)));
+			}
+
+			if (rankings.size() >= 3) {
+				DrawTexture(content.drone, 36, 39, settings.playerTints.at(rankings.at(2)));
+			}
+
+			if (rankings.size() >= 4) {
+				DrawTexture(content.drone, 36, 47, settings.playerTints.at(rankings.at(3)));
+			}
+
+			if (button(content.button_back, 1, 54)) {
+				currentPage = MenuPage::Splash;
+			}
+
+			// Same players on the same level
+			if (button(content.button_play, 54, 54)) {
+				currentPage = MenuPage::Rematch;
+			}
+		}
+	}
+
+private:
+	bool button(Texture texture, const int x, const int y, const bool selected = false) {
+		const Vector2 ray_mousepos = GetScreenToWorld2D(GetMousePosition(), camera);
+		const glm::ivec2 mouse_position(ray_mousepos.x, ray_mousepos.y);
+		const glm::ivec2 image_position(x, y);
+		const glm::ivec2 image_size(texture.width, texture.height);
+		const bool mouse_hover = mouse_position.x >= image_position.x && mouse_position.y >= image_position.y &&
+			mouse_position.x < image_position.x + image_size.x && mouse_position.y < image_position.y + image_size.y;
+
+		const Color color = mouse_hover ? YELLOW : (selected ? GREEN : WHITE);
+		DrawTexture(texture, image_position.x, image_position.y, color);
+
+		if (mouse_hover && IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+			PlaySound(content.menuSound);
+			return true;
+		}
+		else {
+			return false;
+		}
+	}
+};
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include "settings.h"
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define DD_UDP 1
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#else
+#define DD_UDP 0
+#endif
+
+// Messages between the server and its clients, one per datagram. They are sent as they are in memory, little endian.
+namespace Net {
+	enum MessageType : uint8_t {
+		Join = 1, // Client asks for a slot in any session
+		Joined, // Server gives the slot
+		Input, // Client sends the commands of its drone
+		Snapshot, // Server sends the state of the session
+	};
+
+	static constexpr uint16_t serverPort = 1; // On the loopback network
+
+	struct JoinMessage {
+		uint8_t type = Join;
+		uint8_t padding[3] = {};
+	};
+
+	struct JoinedMessage {
+		uint8_t type = Joined;
+		int8_t playerIndex;
+		uint8_t padding[2] = {};
+		uint32_t sessionId;
+	};
+
+	struct InputMessage {
+		uint8_t type = Input;
+		int8_t playerIndex;
+		uint8_t fire;
+		uint8_t padding = 0;
+		uint32_t sessionId;
+		uint32_t sequence; // Older inputs than the last one received are dropped
+		float moveX;
+		float moveY;
+		float shootX;
+		float shootY;
+	};
+
+	struct SnapshotMessage {
+		struct PlayerState {
+			int16_t x;
+			int16_t y;
+			int16_t health;
+			int16_t score;
+		};
+
+		uint8_t type = Snapshot;
+		uint8_t playerCount;
+		uint8_t padding[2] = {};
+		uint32_t sessionId;
+		uint32_t tick;
+		std::array<PlayerState, Settings::maxPlayers> players;
+	};
+
+	static_assert(sizeof(JoinMessage) == 4 && sizeof(JoinedMessage) == 8 && sizeof(InputMessage) == 28 && sizeof(SnapshotMessage) == 44,
+		"Messages are part of the network protocol");
+
+	struct Endpoint {
+		uint32_t address = 0; // IPv4 in host order, unused on the loopback network
+		uint16_t port = 0;
+
+		bool operator==(const Endpoint& other) const {
+			return address == other.address && port == other.port;
+		}
+	};
+
+	struct Datagram {
+		Endpoint from;
+		size_t size = 0;
+		std::array<uint8_t, 256> data;
+	};
+
+	// Unreliable datagrams, like UDP. Both calls never block, and can be made from different threads.
+	class Transport {
+	public:
+		virtual ~Transport() = default;
+		virtual bool send(const Endpoint& to, const void* data, size_t size) = 0;
+		virtual bool receive(Datagram& datagram) = 0;
+	};
+
+	// Reads a message of the given type, false if the datagram is something else
+	template<typename Message>
+	bool read(const Datagram& datagram, Message& message) {
+		if (datagram.size != sizeof(Message) || datagram.data.at(0) != Message().type) {
+			return false;
+		}
+		memcpy(&message, datagram.data.data(), sizeof(Message));
+		return true;
+	}
+
+	template<typename Message>
+	bool write(Transport& transport, const Endpoint& to, const Message& message) {
+		return transport.send(to, &message, sizeof(Message));
+	}
+
+	// In-process stand-in for the network, the ports are the addresses of the mailboxes
+	class LoopbackNetwork {
+	public:
+		void post(const uint16_t to, const Datagram& datagram) {
+			std::lock_guard<std::mutex> lock(mutex);
+			mailboxes[to].push_back(datagram);
+		}
+
+		bool take(const uint16_t port, Datagram& datagram) {
+			std::lock_guard<std::mutex> lock(mutex);
+			std::deque<Datagram>& mailbox = mailboxes[port];
+			if (mailbox.empty()) {
+				return false;
+			}
+			datagram = mailbox.front();
+			mailbox.pop_front();
+			return true;
+		}
+
+	private:
+		std::mutex mutex;
+		std::unordered_map<uint16_t, std::deque<Datagram>> mailboxes;
+	};
+
+	class LoopbackTransport : public Transport {
+	public:
+		LoopbackTransport(LoopbackNetwork& _network, const uint16_t _port) : network(_network), port(_port) {
+		}
+
+		bool send(const Endpoint& to, const void* data, const size_t size) override {
+			Datagram datagram;
+			if (size > datagram.data.size()) {
+				return false;
+			}
+			datagram.from = Endpoint{ 0, port };
+			datagram.size = size;
+			memcpy(datagram.data.data(), data, size);
+			network.post(to.port, datagram);
+			return true;
+		}
+
+		bool receive(Datagram& datagram) override {
+			return network.take(port, datagram);
+		}
+
+	private:
+		LoopbackNetwork& network;
+		uint16_t port;
+	};
+
+#if DD_UDP
+	// Non blocking UDP socket, bound to the port on every interface, or to an ephemeral one for port 0
+	class UdpTransport : public Transport {
+	public:
+		UdpTransport(const uint16_t port) {
+			socketHandle = socket(AF_INET, SOCK_DGRAM, 0);
+			if (socketHandle < 0) {
+				return;
+			}
+
+			sockaddr_in address{};
+			address.sin_family = AF_INET;
+			address.sin_addr.s_addr = htonl(INADDR_ANY);
+			address.sin_port = htons(port);
+
+			if (bind(socketHandle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || fcntl(socketHandle, F_SETFL, O_NONBLOCK) != 0) {
+				close(socketHandle);
+				socketHandle = -1;
+			}
+		}
+
+		UdpTransport(const UdpTransport&) = delete;
+		UdpTransport& operator=(const UdpTransport&) = delete;
+
+		~UdpTransport() override {
+			if (socketHandle >= 0) {
+				close(socketHandle);
+			}
+		}
+
+		bool isOpen() const {
+			return socketHandle >= 0;
+		}
+
+		bool send(const Endpoint& to, const void* data, const size_t size) override {
+			sockaddr_in address{};
+			address.sin_family = AF_INET;
+			address.sin_addr.s_addr = htonl(to.address);
+			address.sin_port = htons(to.port);
+			return sendto(socketHandle, data, size, 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == ssize_t(size);
+		}
+
+		bool receive(Datagram& datagram) override {
+			sockaddr_in address{};
+			socklen_t address_size = sizeof(address);
+			const ssize_t size = recvfrom(socketHandle, datagram.data.data(), datagram.data.size(), 0, reinterpret_cast<sockaddr*>(&address), &address_size);
+			if (size < 0) {
+				return false;
+			}
+
+			datagram.from = Endpoint{ ntohl(address.sin_addr.s_addr), ntohs(address.sin_port) };
+			datagram.size = size_t(size);
+			return true;
+		}
+
+	private:
+		int socketHandle = -1;
+	};
+#endif
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <raylib.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define DD_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define DD_MMAP 0
+#endif
+
+// Read only view of a whole file: memory mapped where available, otherwise read with a single call
+// (on the web the file is already in memory, preloaded with the page)
+class MappedFile {
+public:
+	MappedFile(const std::filesystem::path& path) {
+#if DD_MMAP
+		const int file = open(path.string().c_str(), O_RDONLY);
+		if (file < 0) {
+			return;
+		}
+
+		struct stat status;
+		if (fstat(file, &status) == 0 && status.st_size > 0) {
+			void* mapping = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+			if (mapping != MAP_FAILED) {
+				bytes = static_cast<const unsigned char*>(mapping);
+				byteCount = size_t(status.st_size);
+			}
+		}
+
+		close(file);
+#else
+		FILE* file = fopen(path.string().c_str(), "rb");
+		if (file == nullptr) {
+			return;
+		}
+
+		fseek(file, 0, SEEK_END);
+		const long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		if (size > 0) {
+			buffer.resize(size_t(size));
+			if (fread(buffer.data(), 1, buffer.size(), file) == buffer.size()) {
+				bytes = buffer.data();
+				byteCount = buffer.size();
+			}
+		}
+
+		fclose(file);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile() {
+#if DD_MMAP
+		if (bytes != nullptr) {
+			munmap(const_cast<unsigned char*>(bytes), byteCount);
+		}
+#endif
+	}
+
+	const unsigned char* data() const {
+		return bytes;
+	}
+
+	size_t size() const {
+		return byteCount;
+	}
+
+private:
+	const unsigned char* bytes = nullptr;
+	size_t byteCount = 0;
+#if !DD_MMAP
+	std::vector<unsigned char> buffer;
+#endif
+};
+
+// Asset archive written by destructive_drones_packer: a header, an index sorted by name, then the payloads, each one
+// starting at a multiple of the alignment. Payloads are either the original file, or decoded RGBA pixels or PCM samples.
+// Everything is little endian.
+class AssetPack {
+public:
+	static constexpr uint32_t version = 1;
+	static constexpr uint32_t alignment = 64;
+	static constexpr size_t maxNameLength = 63;
+
+	enum EntryType : uint32_t {
+		Raw,
+		Rgba,
+		Pcm,
+	};
+
+	struct Header {
+		char magic[4]; // "DDPK"
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t alignment;
+	};
+
+	struct Entry {
+		char name[maxNameLength + 1]; // Path relative to the data directory, with forward slashes
+		uint32_t type;
+		uint32_t width; // Rgba
+		uint32_t height; // Rgba
+		uint32_t frameCount; // Pcm
+		uint32_t sampleRate; // Pcm
+		uint32_t sampleSize; // Pcm, bits per sample
+		uint32_t channels; // Pcm
+		uint32_t reserved;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	static_assert(sizeof(Header) == 16, "The pack header is part of the file format");
+	static_assert(sizeof(Entry) == 112, "Pack entries are part of the file format");
+
+	AssetPack(const std::filesystem::path& path) : file(path) {
+		if (file.size() < sizeof(Header)) {
+			return;
+		}
+
+		const Header& header = *reinterpret_cast<const Header*>(file.data());
+		if (memcmp(header.magic, "DDPK", 4) != 0 || header.version != version || sizeof(Header) + size_t(header.entryCount) * sizeof(Entry) > file.size()) {
+			TraceLog(LOG_WARNING, "PACK: %s is not a valid asset pack", path.string().c_str());
+			return;
+		}
+
+		entries = reinterpret_cast<const Entry*>(file.data() + sizeof(Header));
+		entryCount = header.entryCount;
+		TraceLog(LOG_INFO, "PACK: %s opened with %u entries", path.string().c_str(), entryCount);
+	}
+
+	bool isOpen() const {
+		return entries != nullptr;
+	}
+
+	const Entry* find(const std::string& name) const {
+		const Entry* end = entries + entryCount;
+		const Entry* entry = std::lower_bound(entries, end, name, [](const Entry& entry, const std::string& name) { return strcmp(entry.name, name.c_str()) < 0; });
+		if (entry == end || name != entry->name || entry->offset + entry->size > file.size()) {
+			return nullptr;
+		}
+		return entry;
+	}
+
+	const unsigned char* payload(const Entry& entry) const {
+		return file.data() + entry.offset;
+	}
+
+	// Returns a texture with id 0 if the pack doesn't have the entry
+	Texture loadTexture(const std::string& name) const {
+		const Entry* entry = find(name);
+		if (entry == nullptr) {
+			return Texture{};
+		}
+
+		if (entry->type == Rgba) {
+			// Uploaded straight from the mapped file
+			Image image{ const_cast<unsigned char*>(payload(*entry)), int(entry->width), int(entry->height), 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+			return LoadTextureFromImage(image);
+		}
+
+		Image image = LoadImageFromMemory(GetFileExtension(entry->name), payload(*entry), int(entry->size));
+		Texture texture = LoadTextureFromImage(image);
+		UnloadImage(image);
+		return texture;
+	}
+
+	// Returns a wave without data if the pack doesn't have the entry, the caller unloads the wave otherwise
+	Wave loadWave(const std::string& name) const {
+		const Entry* entry = find(name);
+		if (entry == nullptr) {
+			return Wave{};
+		}
+
+		if (entry->type == Pcm) {
+			Wave wave{ entry->frameCount, entry->sampleRate, entry->sampleSize, entry->channels, const_cast<unsigned char*>(payload(*entry)) };
+			return WaveCopy(wave);
+		}
+
+		return LoadWaveFromMemory(GetFileExtension(entry->name), payload(*entry), int(entry->size));
+	}
+
+private:
+	MappedFile file;
+	const Entry* entries = nullptr;
+	uint32_t entryCount = 0;
+};
@@ -0,0 +1,173 @@
+#include <raylib.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "pack.h"
+
+// Bundles the data directory into a single asset pack read by Content:
+// destructive_drones_packer <data directory> <output.pack> [--decode-images] [--decode-sounds]
+// Decoded entries are bigger but are used straight from the mapped file, without decoding at startup.
+
+namespace {
+
+	struct Payload {
+		AssetPack::Entry entry;
+		std::vector<unsigned char> bytes;
+	};
+
+	bool isAsset(const std::filesystem::path& path) {
+		const std::string extension = path.extension().string();
+		return extension == ".png" || extension == ".mp3" || extension == ".wav" || extension == ".ogg";
+	}
+
+	std::vector<unsigned char> readFile(const std::filesystem::path& path) {
+		std::ifstream file(path, std::ios::binary);
+		return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	bool encode(const std::filesystem::path& path, const bool decode_images, const bool decode_sounds, Payload& payload) {
+		const std::string extension = path.extension().string();
+
+		if (decode_images && extension == ".png") {
+			Image image = LoadImage(path.string().c_str());
+			if (image.data == nullptr) {
+				return false;
+			}
+
+			ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+			const unsigned char* pixels = static_cast<const unsigned char*>(image.data);
+			payload.entry.type = AssetPack::Rgba;
+			payload.entry.width = uint32_t(image.width);
+			payload.entry.height = uint32_t(image.height);
+			payload.bytes.assign(pixels, pixels + size_t(image.width) * image.height * 4);
+			UnloadImage(image);
+			return true;
+		}
+
+		if (decode_sounds && extension != ".png") {
+			Wave wave = LoadWave(path.string().c_str());
+			if (wave.data == nullptr) {
+				return false;
+			}
+
+			const unsigned char* samples = static_cast<const unsigned char*>(wave.data);
+			payload.entry.type = AssetPack::Pcm;
+			payload.entry.frameCount = wave.frameCount;
+			payload.entry.sampleRate = wave.sampleRate;
+			payload.entry.sampleSize = wave.sampleSize;
+			payload.entry.channels = wave.channels;
+			payload.bytes.assign(samples, samples + size_t(wave.frameCount) * wave.channels * (wave.sampleSize / 8));
+			UnloadWave(wave);
+			return true;
+		}
+
+		payload.entry.type = AssetPack::Raw;
+		payload.bytes = readFile(path);
+		return !payload.bytes.empty();
+	}
+
+	uint64_t aligned(const uint64_t offset) {
+		return (offset + AssetPack::alignment - 1) / AssetPack::alignment * AssetPack::alignment;
+	}
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> paths;
+	bool decode_images = false;
+	bool decode_sounds = false;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--decode-images") {
+			decode_images = true;
+		}
+		else if (arg == "--decode-sounds") {
+			decode_sounds = true;
+		}
+		else {
+			paths.push_back(arg);
+		}
+	}
+
+	if (paths.size() != 2) {
+		printf("Usage: %s <data directory> <output.pack> [--decode-images] [--decode-sounds]\n", argv[0]);
+		return 1;
+	}
+
+	SetTraceLogLevel(LOG_WARNING);
+
+	const std::filesystem::path input = paths.at(0);
+	const std::filesystem::path output = paths.at(1);
+
+	std::vector<std::filesystem::path> files;
+	for (const std::filesystem::directory_entry& file : std::filesystem::recursive_directory_iterator(input)) {
+		if (file.is_regular_file() && isAsset(file.path())) {
+			files.push_back(file.path());
+		}
+	}
+
+	std::vector<Payload> payloads;
+	for (const std::filesystem::path& file : files) {
+		const std::string name = file.lexically_relative(input).generic_string();
+		if (name.size() > AssetPack::maxNameLength) {
+			printf("Skipping %s, the name is too long\n", name.c_str());
+			continue;
+		}
+
+		Payload payload;
+		memset(&payload.entry, 0, sizeof(AssetPack::Entry));
+		strncpy(payload.entry.name, name.c_str(), AssetPack::maxNameLength);
+		if (!encode(file, decode_images, decode_sounds, payload)) {
+			printf("Couldn't read %s\n", file.string().c_str());
+			return 1;
+		}
+
+		payload.entry.size = payload.bytes.size();
+		payloads.push_back(std::move(payload));
+	}
+
+	// The pack looks entries up with a binary search
+	std::sort(payloads.begin(), payloads.end(), [](const Payload& a, const Payload& b) { return strcmp(a.entry.name, b.entry.name) < 0; });
+
+	uint64_t offset = aligned(sizeof(AssetPack::Header) + payloads.size() * sizeof(AssetPack::Entry));
+	for (Payload& payload : payloads) {
+		payload.entry.offset = offset;
+		offset = aligned(offset + payload.entry.size);
+	}
+
+	std::ofstream file(output, std::ios::binary);
+	if (!file) {
+		printf("Couldn't write %s\n", output.string().c_str());
+		return 1;
+	}
+
+	AssetPack::Header header;
+	memcpy(header.magic, "DDPK", 4);
+	header.version = AssetPack::version;
+	header.entryCount = uint32_t(payloads.size());
+	header.alignment = AssetPack::alignment;
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (const Payload& payload : payloads) {
+		file.write(reinterpret_cast<const char*>(&payload.entry), sizeof(AssetPack::Entry));
+	}
+
+	const std::vector<char> padding(AssetPack::alignment, 0);
+	for (const Payload& payload : payloads) {
+		file.write(padding.data(), std::streamsize(payload.entry.offset - uint64_t(file.tellp())));
+		file.write(reinterpret_cast<const char*>(payload.bytes.data()), std::streamsize(payload.bytes.size()));
+	}
+	file.write(padding.data(), std::streamsize(offset - uint64_t(file.tellp())));
+
+	if (!file) {
+		printf("Couldn't write %s\n", output.string().c_str());
+		return 1;
+	}
+
+	printf("%s: %zu entries, %llu bytes\n", output.string().c_str(), payloads.size(), (unsigned long long)offset);
+	return 0;
+}
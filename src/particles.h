@@ -0,0 +1,151 @@
+#pragma once
+
+#include <raylib.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include "settings.h"
+#include "profiler.h"
+
+// Debris thrown by destroyed tiles. Particles are stored as a structure of arrays with a fixed capacity,
+// so the update loops vectorize and spawning never allocates. They are splatted into a level sized image
+// and drawn with a single texture.
+class DebrisParticles {
+public:
+	static constexpr size_t capacity = 1 << 15;
+
+	const Settings& settings;
+	int width;
+	int height;
+
+	DebrisParticles(const Settings& _settings, const int _width, const int _height) :
+		settings(_settings), width(_width), height(_height), positionsX(capacity), positionsY(capacity), velocitiesX(capacity), velocitiesY(capacity),
+		lives(capacity), pixels(size_t(_width) * _height) {
+	}
+
+	DebrisParticles(const DebrisParticles&) = delete;
+	DebrisParticles& operator=(const DebrisParticles&) = delete;
+
+	~DebrisParticles() {
+		if (texture.id != 0) {
+			UnloadTexture(texture);
+		}
+	}
+
+	size_t size() const {
+		return count;
+	}
+
+	void clear() {
+		count = 0;
+	}
+
+	// Particles that don't fit are dropped
+	void spawn(const std::vector<glm::ivec2>& destroyed_tiles) {
+		std::uniform_real_distribution<float> random_angle(0.0f, glm::radians(360.0f));
+		std::uniform_real_distribution<float> random_unit(0.0f, 1.0f);
+
+		for (const glm::ivec2& tile : destroyed_tiles) {
+			for (int i = 0; i < settings.debrisPerTile && count < capacity; ++i) {
+				const float angle = random_angle(randomGenerator);
+				const float speed = settings.debrisSpeed * (0.5f + random_unit(randomGenerator));
+				positionsX[count] = float(tile.x) + random_unit(randomGenerator);
+				positionsY[count] = float(tile.y) + random_unit(randomGenerator);
+				velocitiesX[count] = std::cos(angle) * speed;
+				velocitiesY[count] = std::sin(angle) * speed;
+				lives[count] = settings.debrisLife * (0.5f + random_unit(randomGenerator));
+				++count;
+			}
+		}
+	}
+
+	void update(const float frame_time) {
+		PROFILE_SCOPE("DebrisParticles::update");
+
+		const float gravity = settings.debrisGravity * frame_time;
+		float* const positions_x = positionsX.data();
+		float* const positions_y = positionsY.data();
+		float* const velocities_x = velocitiesX.data();
+		float* const velocities_y = velocitiesY.data();
+		float* const particle_lives = lives.data();
+
+		for (size_t i = 0; i < count; ++i) {
+			velocities_y[i] += gravity;
+			positions_x[i] += velocities_x[i] * frame_time;
+			positions_y[i] += velocities_y[i] * frame_time;
+			particle_lives[i] -= frame_time;
+		}
+
+		// Dead particles are replaced by the last ones, the order doesn't matter
+		for (size_t i = 0; i < count;) {
+			if (particle_lives[i] > 0) {
+				++i;
+				continue;
+			}
+
+			--count;
+			positions_x[i] = positions_x[count];
+			positions_y[i] = positions_y[count];
+			velocities_x[i] = velocities_x[count];
+			velocities_y[i] = velocities_y[count];
+			particle_lives[i] = particle_lives[count];
+		}
+	}
+
+	// Writes the particles into the image, fading out with their remaining life
+	void splat() {
+		PROFILE_SCOPE("DebrisParticles::splat");
+
+		std::fill(pixels.begin(), pixels.end(), glm::u8vec4(0, 0, 0, 0));
+
+		const float alpha_scale = 255.0f / std::max(settings.debrisLife, 0.001f);
+		for (size_t i = 0; i < count; ++i) {
+			const int x = int(positionsX[i]);
+			const int y = int(positionsY[i]);
+			if (positionsX[i] >= 0 && positionsY[i] >= 0 && x < width && y < height) {
+				const int alpha = std::min(int(lives[i] * alpha_scale), 255);
+				glm::u8vec4& pixel = pixels[size_t(y) * width + x];
+				pixel = glm::u8vec4(200, 200, 200, std::max(int(pixel.w), alpha));
+			}
+		}
+	}
+
+	void draw() {
+		if (count == 0) {
+			return;
+		}
+
+		if (texture.id == 0) {
+			Image dummy_image = GenImageColor(width, height, BLANK);
+			texture = LoadTextureFromImage(dummy_image);
+			UnloadImage(dummy_image);
+		}
+
+		splat();
+		UpdateTexture(texture, pixels.data());
+		DrawTexture(texture, 0, 0, WHITE);
+	}
+
+	// Draws the texture of the last draw() again, for another pass over the same frame without splatting again
+	void redraw() const {
+		if (count == 0 || texture.id == 0) {
+			return;
+		}
+
+		DrawTexture(texture, 0, 0, WHITE);
+	}
+
+private:
+	std::vector<float> positionsX;
+	std::vector<float> positionsY;
+	std::vector<float> velocitiesX;
+	std::vector<float> velocitiesY;
+	std::vector<float> lives;
+	size_t count = 0;
+
+	std::vector<glm::u8vec4> pixels;
+	Texture texture{};
+	std::mt19937 randomGenerator{ 1234 };
+};
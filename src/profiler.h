@@ -0,0 +1,198 @@
+#pragma once
+
+#include <raylib.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef DD_PROFILER
+#define DD_PROFILER 1
+#endif
+
+// Scoped timers recorded into a ring buffer per thread, with an on-screen overlay and Chrome trace export (chrome://tracing, ui.perfetto.dev)
+class Profiler {
+public:
+	static constexpr size_t samplesPerThread = 1 << 16;
+	static constexpr size_t overlayScopes = 16;
+
+	struct Sample {
+		const char* name;
+		int64_t start;
+		int64_t duration;
+	};
+
+	struct ThreadBuffer {
+		int threadIndex;
+		std::array<Sample, samplesPerThread> samples;
+		std::atomic<uint64_t> count{ 0 };
+	};
+
+	struct Counter {
+		const char* name;
+		double value;
+	};
+
+	struct ScopeStats {
+		const char* name;
+		double frameMs;
+		double averageMs;
+		double maxMs;
+	};
+
+	static Profiler& instance() {
+		static Profiler profiler;
+		return profiler;
+	}
+
+	static int64_t now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	ThreadBuffer& threadBuffer() {
+		thread_local ThreadBuffer* buffer = nullptr;
+		if (buffer == nullptr) {
+			std::lock_guard<std::mutex> lock(mutex);
+			buffers.emplace_back(new ThreadBuffer());
+			buffer = buffers.back().get();
+			buffer->threadIndex = int(buffers.size()) - 1;
+		}
+		return *buffer;
+	}
+
+	void record(const char* name, const int64_t start, const int64_t end) {
+		ThreadBuffer& buffer = threadBuffer();
+		const uint64_t index = buffer.count.load(std::memory_order_relaxed);
+		buffer.samples[index % samplesPerThread] = Sample{ name, start, end - start };
+		buffer.count.store(index + 1, std::memory_order_release);
+	}
+
+	// Aggregates the samples recorded by the calling thread since the previous call, for the overlay
+	void endFrame() {
+		ThreadBuffer& buffer = threadBuffer();
+		const uint64_t count = buffer.count.load(std::memory_order_acquire);
+		const uint64_t first = std::max(frameStart, count > samplesPerThread ? count - samplesPerThread : 0);
+
+		for (ScopeStats& stats : scopeStats) {
+			stats.frameMs = 0;
+		}
+
+		for (uint64_t i = first; i < count; ++i) {
+			const Sample& sample = buffer.samples[i % samplesPerThread];
+			auto stats = std::find_if(scopeStats.begin(), scopeStats.end(), [&sample](const ScopeStats& stats) { return stats.name == sample.name; });
+			if (stats == scopeStats.end()) {
+				if (scopeStats.size() >= overlayScopes) {
+					continue;
+				}
+				scopeStats.push_back(ScopeStats{ sample.name, 0, 0, 0 });
+				stats = std::prev(scopeStats.end());
+			}
+			stats->frameMs += double(sample.duration) / 1e6;
+		}
+
+		for (ScopeStats& stats : scopeStats) {
+			stats.averageMs = stats.averageMs * 0.95 + stats.frameMs * 0.05;
+			stats.maxMs = std::max(stats.maxMs * 0.995, stats.frameMs);
+		}
+
+		frameStart = count;
+	}
+
+	// Per frame values shown below the scopes in the overlay
+	void setCounter(const char* name, const double value) {
+		auto counter = std::find_if(counters.begin(), counters.end(), [name](const Counter& counter) { return counter.name == name; });
+		if (counter != counters.end()) {
+			counter->value = value;
+		}
+		else {
+			counters.push_back(Counter{ name, value });
+		}
+	}
+
+	void drawOverlay() const {
+		const int font_size = 10;
+		const int line_height = font_size + 2;
+
+		DrawRectangle(0, 0, 300, line_height * int(scopeStats.size() + counters.size() + 1) + 4, Color{ 0, 0, 0, 180 });
+		DrawText("scope                    frame    avg    max", 4, 2, font_size, LIGHTGRAY);
+
+		for (size_t i = 0; i < scopeStats.size(); ++i) {
+			const ScopeStats& stats = scopeStats.at(i);
+			std::array<char, 128> line;
+			snprintf(line.data(), line.size(), "%-24s %6.2f %6.2f %6.2f", stats.name, stats.frameMs, stats.averageMs, stats.maxMs);
+			DrawText(line.data(), 4, 2 + line_height * int(i + 1), font_size, WHITE);
+		}
+
+		for (size_t i = 0; i < counters.size(); ++i) {
+			const Counter& counter = counters.at(i);
+			std::array<char, 128> line;
+			snprintf(line.data(), line.size(), "%-24s %6.0f", counter.name, counter.value);
+			DrawText(line.data(), 4, 2 + line_height * int(scopeStats.size() + i + 1), font_size, YELLOW);
+		}
+	}
+
+	// Writes the content of all the ring buffers as Chrome trace events
+	bool exportTrace(const std::string& path) {
+		FILE* file = fopen(path.c_str(), "w");
+		if (file == nullptr) {
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+		bool first_event = true;
+		for (const std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+			const uint64_t count = buffer->count.load(std::memory_order_acquire);
+			const uint64_t first = count > samplesPerThread ? count - samplesPerThread : 0;
+
+			for (uint64_t i = first; i < count; ++i) {
+				const Sample& sample = buffer->samples[i % samplesPerThread];
+				fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", first_event ? "" : ",\n",
+					sample.name, buffer->threadIndex, double(sample.start - epoch) / 1e3, double(sample.duration) / 1e3);
+				first_event = false;
+			}
+		}
+
+		fprintf(file, "\n]}\n");
+		fclose(file);
+		return true;
+	}
+
+private:
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	std::vector<ScopeStats> scopeStats;
+	std::vector<Counter> counters;
+	uint64_t frameStart = 0;
+	int64_t epoch = now();
+};
+
+class ProfileScope {
+public:
+	ProfileScope(const char* _name) : name(_name), start(Profiler::now()) {
+	}
+
+	~ProfileScope() {
+		Profiler::instance().record(name, start, Profiler::now());
+	}
+
+private:
+	const char* name;
+	int64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if DD_PROFILER
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
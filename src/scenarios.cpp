@@ -0,0 +1,374 @@
+#include <raylib.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "settings.h"
+#include "level.h"
+#include "session.h"
+#include "generator.h"
+#include "particles.h"
+#include "benchmark.h"
+
+// Fixed match played for a number of ticks, the same way on every run: fixed seeds, bots and scripted players
+struct Scenario {
+	std::string name;
+	std::string map; // CSV path, or empty for a generated level
+	LevelGenerator::Options generated;
+	int bots = 0;
+	int scripted = 0; // Remote players after the bots, driven by script
+	std::function<void(Settings&)> configure;
+	std::function<void(Session&, Player&, uint64_t)> script; // Sets the input of a scripted player before each tick
+};
+
+struct ScenarioResult {
+	std::string name;
+	double p50; // Nanoseconds per tick, update and render prep
+	double p99;
+	double updateP50; // Session::update alone
+	double updateP99;
+};
+
+struct Baseline {
+	double tolerance50 = 0.25; // Allowed slowdown, as a fraction of the baseline
+	double tolerance99 = 0.5;
+	std::vector<ScenarioResult> results;
+};
+
+// Scripted drones stand still, turn their aim a little every tick and fire whatever they hold, without running out
+void spinAndFire(Player& player, const WeaponType weapon, const uint64_t tick) {
+	const float angle = float(tick) * 0.02f + float(player.playerIndex) * 1.57f;
+	player.weapon = weapon;
+	player.ammo = 1000;
+	player.input.move = glm::vec2(0, 0);
+	player.input.shoot = glm::vec2(std::cos(angle), std::sin(angle));
+	player.input.fire = true;
+}
+
+std::vector<Scenario> scenarios() {
+	std::vector<Scenario> list;
+
+	{
+		Scenario scenario;
+		scenario.name = "brawl (3 bots, map0)";
+		scenario.map = "map0.csv";
+		scenario.bots = 3;
+		list.push_back(scenario);
+	}
+
+	{
+		Scenario scenario;
+		scenario.name = "rocket spam (4 scripted, map0)";
+		scenario.map = "map0.csv";
+		scenario.scripted = 4;
+		scenario.configure = [](Settings& settings) {
+			settings.playerMaxHealth = 1e9f; // Nobody dies, the rockets keep flying and digging
+			settings.weapons.at(WeaponType::RocketLauncher).shootDelay = 0.25f;
+		};
+		scenario.script = [](Session&, Player& player, const uint64_t tick) {
+			spinAndFire(player, WeaponType::RocketLauncher, tick);
+		};
+		list.push_back(scenario);
+	}
+
+	{
+		// A shotgun burst every tick from each drone, with slow pellets that live long and don't damage terrain
+		Scenario scenario;
+		scenario.name = "max projectiles (4 scripted, map0)";
+		scenario.map = "map0.csv";
+		scenario.scripted = 4;
+		scenario.configure = [](Settings& settings) {
+			settings.playerMaxHealth = 1e9f;
+			WeaponSettings& shotgun = settings.weapons.at(WeaponType::Shotgun);
+			shotgun.shootDelay = 1.0f / settings.tickRate;
+			shotgun.projectileSpeed = 10.0f;
+			shotgun.projectileDamage = 0;
+			shotgun.projectileLife = 2.0f;
+		};
+		scenario.script = [](Session&, Player& player, const uint64_t tick) {
+			spinAndFire(player, WeaponType::Shotgun, tick);
+		};
+		list.push_back(scenario);
+	}
+
+	for (const int bots : { 2, 4 }) {
+		Scenario scenario;
+		scenario.name = "arena (" + std::to_string(bots) + " bots, 256x256)";
+		scenario.generated.layout = LevelGenerator::Layout::Arena;
+		scenario.generated.width = 256;
+		scenario.generated.height = 256;
+		scenario.generated.seed = 1234;
+		scenario.bots = bots;
+		list.push_back(scenario);
+	}
+
+	{
+		Scenario scenario;
+		scenario.name = "caves fog of war (4 bots, 256x256)";
+		scenario.generated.layout = LevelGenerator::Layout::Caves;
+		scenario.generated.width = 256;
+		scenario.generated.height = 256;
+		scenario.generated.seed = 1234;
+		scenario.bots = 4;
+		scenario.configure = [](Settings& settings) {
+			settings.fogOfWar = true;
+		};
+		list.push_back(scenario);
+	}
+
+	return list;
+}
+
+// Plays the scenario, restarting the match when someone wins, and times every tick after the warmup. Render prep is
+// what a frame does before drawing: the level pixels when tiles were destroyed, and the debris.
+bool runScenario(const Scenario& scenario, const int warmup_ticks, const int ticks, ScenarioResult& result) {
+	Settings settings;
+	if (scenario.configure) {
+		scenario.configure(settings);
+	}
+
+	std::unique_ptr<Level> level;
+	if (scenario.map.empty()) {
+		level.reset(new Level(settings, scenario.generated.width, scenario.generated.height));
+		if (!LevelGenerator::generate(scenario.generated, *level)) {
+			printf("Couldn't generate the level of %s\n", scenario.name.c_str());
+			return false;
+		}
+	}
+	else {
+		level.reset(new Level(settings, scenario.map));
+	}
+
+	if (int(level->playerSpawns.size()) < scenario.bots + scenario.scripted) {
+		printf("Not enough spawns for %s\n", scenario.name.c_str());
+		return false;
+	}
+
+	Session session(settings, *level, 1234);
+	for (int i = 0; i < scenario.bots; ++i) {
+		session.addPlayer(i, Controller::Bot);
+	}
+	for (int i = 0; i < scenario.scripted; ++i) {
+		session.addPlayer(scenario.bots + i, Controller::Remote);
+	}
+
+	DebrisParticles debris(settings, level->width, level->height);
+	Level::Pixels pixels;
+	const float tick_time = 1.0f / settings.tickRate;
+
+	std::vector<double> tick_samples;
+	std::vector<double> update_samples;
+	tick_samples.reserve(ticks);
+	update_samples.reserve(ticks);
+
+	for (uint64_t tick = 0; tick < uint64_t(warmup_ticks + ticks); ++tick) {
+		for (Player& player : session.players) {
+			if (player.controller == Controller::Remote) {
+				scenario.script(session, player, tick);
+			}
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		session.update(tick_time);
+		const auto updated = std::chrono::steady_clock::now();
+
+		if (session.level.textureDirty) {
+			session.level.buildPixels(pixels);
+			session.level.textureDirty = false;
+		}
+		debris.spawn(session.destroyedTiles);
+		debris.update(tick_time);
+		debris.splat();
+		doNotOptimize(pixels);
+		const auto end = std::chrono::steady_clock::now();
+
+		if (tick >= uint64_t(warmup_ticks)) {
+			tick_samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+			update_samples.push_back(std::chrono::duration<double, std::nano>(updated - start).count());
+		}
+
+		if (session.checkEndgame().has_value()) {
+			session.restart(*level);
+			debris.clear();
+		}
+	}
+
+	std::sort(tick_samples.begin(), tick_samples.end());
+	std::sort(update_samples.begin(), update_samples.end());
+
+	result.name = scenario.name;
+	result.p50 = Benchmark::percentile(tick_samples, 0.50);
+	result.p99 = Benchmark::percentile(tick_samples, 0.99);
+	result.updateP50 = Benchmark::percentile(update_samples, 0.50);
+	result.updateP99 = Benchmark::percentile(update_samples, 0.99);
+	return true;
+}
+
+// Number after "key": in the line, the baseline is read a line at a time in the layout writeBaseline uses
+bool readNumber(const std::string& line, const std::string& key, double& value) {
+	const size_t position = line.find("\"" + key + "\":");
+	if (position == std::string::npos) {
+		return false;
+	}
+	value = std::strtod(line.c_str() + position + key.size() + 3, nullptr);
+	return true;
+}
+
+bool readBaseline(const std::string& path, Baseline& baseline) {
+	std::ifstream stream(path);
+	if (!stream) {
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(stream, line)) {
+		const size_t name_start = line.find("\"name\": \"");
+		if (name_start == std::string::npos) {
+			readNumber(line, "toleranceP50", baseline.tolerance50);
+			readNumber(line, "toleranceP99", baseline.tolerance99);
+			continue;
+		}
+
+		ScenarioResult result{};
+		const size_t name_end = line.find('"', name_start + 9);
+		result.name = line.substr(name_start + 9, name_end - name_start - 9);
+		if (readNumber(line, "p50", result.p50) && readNumber(line, "p99", result.p99)) {
+			baseline.results.push_back(result);
+		}
+	}
+
+	return true;
+}
+
+bool writeBaseline(const std::string& path, const Baseline& baseline) {
+	FILE* file = fopen(path.c_str(), "w");
+	if (file == nullptr) {
+		return false;
+	}
+
+	fprintf(file, "{\n\t\"unit\": \"ns/tick\",\n\t\"toleranceP50\": %.2f,\n\t\"toleranceP99\": %.2f,\n\t\"scenarios\": [\n", baseline.tolerance50, baseline.tolerance99);
+	for (size_t i = 0; i < baseline.results.size(); ++i) {
+		const ScenarioResult& result = baseline.results.at(i);
+		fprintf(file, "\t\t{ \"name\": \"%s\", \"p50\": %.0f, \"p99\": %.0f }%s\n", result.name.c_str(), result.p50, result.p99, i + 1 < baseline.results.size() ? "," : "");
+	}
+	fprintf(file, "\t]\n}\n");
+
+	fclose(file);
+	return true;
+}
+
+// End to end performance gate: plays canned scenarios and compares the per tick cost to a baseline. Runs without
+// a window from the directory containing the game data, and exits with 1 when a scenario got slower than allowed:
+// destructive_drones_scenarios [--baseline perf/baseline.json] [--write-baseline path] [--filter substring] [--warmup N] [--ticks N] [--runs N]
+int main(int argc, char** argv) {
+	std::string baseline_path;
+	std::string output_path;
+	std::string filter;
+	int warmup_ticks = 240;
+	int ticks = 2400;
+	int runs = 3;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		const bool has_value = i + 1 < argc;
+
+		if (arg == "--baseline" && has_value) {
+			baseline_path = argv[++i];
+		}
+		else if (arg == "--write-baseline" && has_value) {
+			output_path = argv[++i];
+		}
+		else if (arg == "--filter" && has_value) {
+			filter = argv[++i];
+		}
+		else if (arg == "--warmup" && has_value) {
+			warmup_ticks = std::atoi(argv[++i]);
+		}
+		else if (arg == "--ticks" && has_value) {
+			ticks = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (arg == "--runs" && has_value) {
+			runs = std::max(std::atoi(argv[++i]), 1);
+		}
+		else {
+			printf("Usage: %s [--baseline path] [--write-baseline path] [--filter substring] [--warmup N] [--ticks N] [--runs N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	SetTraceLogLevel(LOG_WARNING);
+
+	Baseline baseline;
+	if (!baseline_path.empty() && !readBaseline(baseline_path, baseline)) {
+		printf("Couldn't read %s\n", baseline_path.c_str());
+		return 1;
+	}
+
+	printf("%-40s %12s %12s %12s %12s %12s %12s\n", "scenario", "update p50", "update p99", "p50", "p99", "base p50", "base p99");
+
+	Baseline measured;
+	measured.tolerance50 = baseline.tolerance50;
+	measured.tolerance99 = baseline.tolerance99;
+	int regressions = 0;
+	int missing = 0; // Scenarios without a baseline entry, a new or renamed one must get one before it passes
+
+	for (const Scenario& scenario : scenarios()) {
+		if (!filter.empty() && scenario.name.find(filter) == std::string::npos) {
+			continue;
+		}
+
+		// Best of the runs, what the machine was doing meanwhile only ever makes them slower
+		ScenarioResult result;
+		for (int run = 0; run < runs; ++run) {
+			ScenarioResult run_result;
+			if (!runScenario(scenario, warmup_ticks, ticks, run_result)) {
+				return 1;
+			}
+
+			if (run == 0) {
+				result = run_result;
+			}
+			else {
+				result.p50 = std::min(result.p50, run_result.p50);
+				result.p99 = std::min(result.p99, run_result.p99);
+				result.updateP50 = std::min(result.updateP50, run_result.updateP50);
+				result.updateP99 = std::min(result.updateP99, run_result.updateP99);
+			}
+		}
+		measured.results.push_back(result);
+
+		const auto reference = std::find_if(baseline.results.begin(), baseline.results.end(), [&](const ScenarioResult& entry) { return entry.name == result.name; });
+		if (reference == baseline.results.end()) {
+			printf("%-40s %12.0f %12.0f %12.0f %12.0f %12s %12s%s\n", result.name.c_str(), result.updateP50, result.updateP99, result.p50, result.p99, "-", "-",
+				baseline_path.empty() ? "" : "  NO BASELINE");
+			missing += baseline_path.empty() ? 0 : 1;
+			continue;
+		}
+
+		const bool slower = result.p50 > reference->p50 * (1 + baseline.tolerance50) || result.p99 > reference->p99 * (1 + baseline.tolerance99);
+		regressions += slower ? 1 : 0;
+		printf("%-40s %12.0f %12.0f %12.0f %12.0f %12.0f %12.0f  %s\n", result.name.c_str(), result.updateP50, result.updateP99, result.p50, result.p99,
+			reference->p50, reference->p99, slower ? "REGRESSION" : "ok");
+	}
+
+	if (!output_path.empty() && !writeBaseline(output_path, measured)) {
+		printf("Couldn't write %s\n", output_path.c_str());
+		return 1;
+	}
+
+	if (missing > 0) {
+		printf("%d scenario(s) missing from %s, add them with --write-baseline\n", missing, baseline_path.c_str());
+	}
+
+	if (regressions > 0) {
+		printf("%d scenario(s) slower than the baseline allows (p50 +%.0f%%, p99 +%.0f%%)\n", regressions, baseline.tolerance50 * 100, baseline.tolerance99 * 100);
+	}
+
+	return regressions == 0 && missing == 0 ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Runs periodic jobs on a pool of threads, each one on its own deadline: the job due first runs first, and a job
+// is never run by two threads at once. A job that falls more than maxBacklog periods behind skips the missed runs
+// instead of bursting to catch up.
+class DeadlineScheduler {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// Called with the job index and the deadline of the run
+	using Run = std::function<void(size_t, Clock::time_point)>;
+
+	static constexpr int maxBacklog = 4;
+
+	DeadlineScheduler(const int thread_count, const Run& _run) : run(_run) {
+		for (int i = 0; i < thread_count; ++i) {
+			threads.emplace_back([this]() { work(); });
+		}
+	}
+
+	DeadlineScheduler(const DeadlineScheduler&) = delete;
+	DeadlineScheduler& operator=(const DeadlineScheduler&) = delete;
+
+	~DeadlineScheduler() {
+		stop();
+	}
+
+	void add(const size_t job, const Clock::time_point first_deadline, const Clock::duration period) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (job >= periods.size()) {
+			periods.resize(job + 1);
+		}
+		periods.at(job) = period;
+		queue.push(Entry{ first_deadline, job });
+		wakeUp.notify_one();
+	}
+
+	// Waits for the runs in progress, the ones not started are dropped
+	void stop() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			running = false;
+		}
+		wakeUp.notify_all();
+
+		for (std::thread& thread : threads) {
+			if (thread.joinable()) {
+				thread.join();
+			}
+		}
+	}
+
+private:
+	struct Entry {
+		Clock::time_point deadline;
+		size_t job;
+
+		bool operator>(const Entry& other) const {
+			return deadline > other.deadline;
+		}
+	};
+
+	Run run;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+	std::vector<Clock::duration> periods;
+	bool running = true;
+	std::vector<std::thread> threads;
+
+	void work() {
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (running) {
+			if (queue.empty()) {
+				wakeUp.wait(lock);
+				continue;
+			}
+
+			const Entry entry = queue.top();
+			if (Clock::now() < entry.deadline) {
+				// Woken up early by a new job or by stop, the top is checked again
+				wakeUp.wait_until(lock, entry.deadline);
+				continue;
+			}
+
+			queue.pop();
+			const Clock::duration period = periods.at(entry.job);
+
+			lock.unlock();
+			run(entry.job, entry.deadline);
+			lock.lock();
+
+			Clock::time_point next_deadline = entry.deadline + period;
+			const Clock::time_point now = Clock::now();
+			if (next_deadline + period * maxBacklog < now) {
+				next_deadline = now;
+			}
+
+			queue.push(Entry{ next_deadline, entry.job });
+			wakeUp.notify_one();
+		}
+	}
+};
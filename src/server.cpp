@@ -0,0 +1,418 @@
+#include <raylib.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "settings.h"
+#include "level.h"
+#include "embedded_maps.h"
+#include "session.h"
+#include "scheduler.h"
+#include "net.h"
+#include "spectator.h"
+
+// Headless server hosting many sessions at once. Each session ticks on its own deadline on a pool of threads,
+// with bots and remote players whose input comes from the network:
+// destructive_drones_server [--sessions N] [--bots N] [--threads N] [--duration seconds] [--map map0.csv]
+//                           [--udp port] [--clients N] [--snapshot-interval ticks] [--seed N]
+// Without --udp the server and its clients talk over an in-process loopback network. --clients starts simulated
+// clients in the same process, which join and send random inputs, over UDP to 127.0.0.1 or over the loopback network.
+// --spectate publishes the state of the first N sessions in shared memory every tick, for destructive_drones_viewer.
+
+using Clock = DeadlineScheduler::Clock;
+
+struct HostedSession {
+	uint32_t id;
+	Session session;
+
+	// Shared with the network thread
+	std::mutex clientsMutex;
+	std::array<std::optional<Net::Endpoint>, Settings::maxPlayers> clients;
+	std::array<PlayerInput, Settings::maxPlayers> inputs;
+	std::array<uint32_t, Settings::maxPlayers> inputSequences{};
+
+	// Written by the thread running the tick
+	uint64_t ticks = 0;
+	uint64_t overruns = 0; // Ticks that ended after the deadline of the next one
+	int matches = 0;
+	double maxLateness = 0; // Seconds between a deadline and the start of its tick
+	double tickSeconds = 0;
+
+#if DD_SHARED_MEMORY
+	std::unique_ptr<Spectator::Publisher> spectator; // Only for the sessions being watched
+#endif
+
+	HostedSession(const uint32_t _id, const Settings& settings, const Level& level, const unsigned seed) : id(_id), session(settings, level, seed) {
+	}
+};
+
+class Server {
+public:
+	const Settings& settings;
+	const Level& level;
+	Net::Transport& transport;
+	std::vector<std::unique_ptr<HostedSession>> sessions;
+	int snapshotInterval;
+
+	Server(const Settings& _settings, const Level& _level, Net::Transport& _transport, const int session_count, const int bots, const int snapshot_interval, const unsigned seed) :
+		settings(_settings), level(_level), transport(_transport), snapshotInterval(snapshot_interval) {
+		for (int i = 0; i < session_count; ++i) {
+			sessions.emplace_back(new HostedSession(uint32_t(i), settings, level, seed + unsigned(i)));
+
+			Session& session = sessions.back()->session;
+			for (int j = 0; j < Settings::maxPlayers; ++j) {
+				session.addPlayer(j, j < bots ? Controller::Bot : Controller::Remote);
+			}
+		}
+	}
+
+	// Runs on the scheduler threads, never twice at once for the same session
+	void tick(const size_t index, const Clock::time_point deadline) {
+		HostedSession& hosted = *sessions.at(index);
+		const Clock::time_point start = Clock::now();
+		const double period = 1.0 / settings.tickRate;
+
+		{
+			std::lock_guard<std::mutex> lock(hosted.clientsMutex);
+			for (Player& player : hosted.session.players) {
+				player.input = hosted.inputs.at(player.playerIndex);
+			}
+		}
+
+		hosted.session.update(float(period));
+		if (hosted.session.checkEndgame().has_value()) {
+			hosted.session.restart(level);
+			hosted.matches += 1;
+		}
+
+		hosted.ticks += 1;
+#if DD_SHARED_MEMORY
+		if (hosted.spectator) {
+			hosted.spectator->publish(hosted.session, hosted.ticks);
+		}
+#endif
+		if (hosted.ticks % uint64_t(snapshotInterval) == 0) {
+			sendSnapshot(hosted);
+		}
+
+		const Clock::time_point end = Clock::now();
+		hosted.maxLateness = std::max(hosted.maxLateness, std::chrono::duration<double>(start - deadline).count());
+		hosted.tickSeconds += std::chrono::duration<double>(end - start).count();
+		if (std::chrono::duration<double>(end - deadline).count() > period) {
+			hosted.overruns += 1;
+		}
+	}
+
+	// Runs on the network thread
+	void receive() {
+		Net::Datagram datagram;
+		while (transport.receive(datagram)) {
+			Net::JoinMessage join;
+			Net::InputMessage input;
+
+			if (Net::read(datagram, join)) {
+				handleJoin(datagram.from);
+			}
+			else if (Net::read(datagram, input) && input.sessionId < sessions.size() && input.playerIndex >= 0 && input.playerIndex < Settings::maxPlayers) {
+				HostedSession& hosted = *sessions.at(input.sessionId);
+				std::lock_guard<std::mutex> lock(hosted.clientsMutex);
+
+				// Only from the client that owns the slot, and only newer than what's already there
+				const std::optional<Net::Endpoint>& owner = hosted.clients.at(input.playerIndex);
+				if (owner.has_value() && *owner == datagram.from && input.sequence > hosted.inputSequences.at(input.playerIndex)) {
+					hosted.inputSequences.at(input.playerIndex) = input.sequence;
+					hosted.inputs.at(input.playerIndex) = PlayerInput{ glm::vec2(input.moveX, input.moveY), glm::vec2(input.shootX, input.shootY), input.fire != 0 };
+				}
+			}
+		}
+	}
+
+private:
+	// Joins the first session with a free remote slot, or sends the slot back again if the client already has one
+	void handleJoin(const Net::Endpoint& from) {
+		for (std::unique_ptr<HostedSession>& hosted : sessions) {
+			std::lock_guard<std::mutex> lock(hosted->clientsMutex);
+
+			for (const Player& player : hosted->session.players) {
+				std::optional<Net::Endpoint>& client = hosted->clients.at(player.playerIndex);
+				if (player.controller != Controller::Remote || (client.has_value() && !(*client == from))) {
+					continue;
+				}
+
+				client = from;
+				Net::JoinedMessage joined;
+				joined.playerIndex = int8_t(player.playerIndex);
+				joined.sessionId = hosted->id;
+				Net::write(transport, from, joined);
+				return;
+			}
+		}
+	}
+
+	void sendSnapshot(HostedSession& hosted) {
+		Net::SnapshotMessage snapshot;
+		snapshot.sessionId = hosted.id;
+		snapshot.tick = uint32_t(hosted.ticks);
+		snapshot.playerCount = 0;
+		for (const Player& player : hosted.session.players) {
+			snapshot.players.at(snapshot.playerCount++) = Net::SnapshotMessage::PlayerState{
+				int16_t(player.bounds.position.x), int16_t(player.bounds.position.y), int16_t(player.health), int16_t(player.score) };
+		}
+
+		std::lock_guard<std::mutex> lock(hosted.clientsMutex);
+		for (const std::optional<Net::Endpoint>& client : hosted.clients) {
+			if (client.has_value()) {
+				Net::write(transport, *client, snapshot);
+			}
+		}
+	}
+};
+
+// Joins, then sends random commands at a fixed rate and counts the snapshots it gets
+struct SimulatedClient {
+	std::unique_ptr<Net::Transport> transport;
+	Net::Endpoint server;
+	std::mt19937 randomGenerator;
+	int playerIndex = -1;
+	uint32_t sessionId = 0;
+	uint32_t sequence = 0;
+	uint64_t snapshots = 0;
+	Clock::time_point lastJoin;
+
+	void update(const Clock::time_point now) {
+		Net::Datagram datagram;
+		while (transport->receive(datagram)) {
+			Net::JoinedMessage joined;
+			Net::SnapshotMessage snapshot;
+
+			if (Net::read(datagram, joined)) {
+				playerIndex = joined.playerIndex;
+				sessionId = joined.sessionId;
+			}
+			else if (Net::read(datagram, snapshot)) {
+				snapshots += 1;
+			}
+		}
+
+		if (playerIndex < 0) {
+			// Datagrams get lost, joins are sent again
+			if (now - lastJoin > std::chrono::milliseconds(500)) {
+				Net::write(*transport, server, Net::JoinMessage());
+				lastJoin = now;
+			}
+			return;
+		}
+
+		std::uniform_real_distribution<float> random_axis(-1.0f, 1.0f);
+		Net::InputMessage input;
+		input.playerIndex = int8_t(playerIndex);
+		input.sessionId = sessionId;
+		input.sequence = ++sequence;
+		input.moveX = random_axis(randomGenerator);
+		input.moveY = random_axis(randomGenerator);
+		input.shootX = random_axis(randomGenerator);
+		input.shootY = random_axis(randomGenerator);
+		input.fire = random_axis(randomGenerator) > 0 ? 1 : 0;
+		Net::write(*transport, server, input);
+	}
+};
+
+int main(int argc, char** argv) {
+	std::string map_path = "map0.csv";
+	int session_count = 100;
+	int bots = 2;
+	int thread_count = int(std::max(std::thread::hardware_concurrency(), 1u));
+	double duration = 10;
+	int udp_port = -1;
+	int client_count = -1;
+	int snapshot_interval = 4;
+	unsigned seed = 1;
+	int spectated = 0;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		const bool has_value = i + 1 < argc;
+
+		if (arg == "--sessions" && has_value) {
+			session_count = std::atoi(argv[++i]);
+		}
+		else if (arg == "--bots" && has_value) {
+			bots = std::atoi(argv[++i]);
+		}
+		else if (arg == "--threads" && has_value) {
+			thread_count = std::atoi(argv[++i]);
+		}
+		else if (arg == "--duration" && has_value) {
+			duration = std::atof(argv[++i]);
+		}
+		else if (arg == "--map" && has_value) {
+			map_path = argv[++i];
+		}
+		else if (arg == "--udp" && has_value) {
+			udp_port = std::atoi(argv[++i]);
+		}
+		else if (arg == "--clients" && has_value) {
+			client_count = std::atoi(argv[++i]);
+		}
+		else if (arg == "--snapshot-interval" && has_value) {
+			snapshot_interval = std::atoi(argv[++i]);
+		}
+		else if (arg == "--seed" && has_value) {
+			seed = unsigned(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--spectate" && has_value) {
+			spectated = std::atoi(argv[++i]);
+		}
+		else {
+			printf("Usage: %s [--sessions N] [--bots N] [--threads N] [--duration seconds] [--map path] [--udp port] [--clients N] [--snapshot-interval ticks] [--seed N] [--spectate N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	bots = std::clamp(bots, 0, Settings::maxPlayers);
+	thread_count = std::max(thread_count, 1);
+	snapshot_interval = std::max(snapshot_interval, 1);
+	if (client_count < 0) {
+		client_count = session_count * (Settings::maxPlayers - bots);
+	}
+
+	SetTraceLogLevel(LOG_WARNING);
+
+	const Settings settings;
+	LevelCache levels(settings, { EmbeddedMaps::all.begin(), EmbeddedMaps::all.end() });
+	const std::shared_ptr<const Level> level = levels.get(map_path);
+	if (level->playerSpawns.size() < size_t(Settings::maxPlayers)) {
+		printf("%s needs %d player spawns\n", map_path.c_str(), Settings::maxPlayers);
+		return 1;
+	}
+
+	Net::LoopbackNetwork loopback;
+	std::unique_ptr<Net::Transport> transport;
+	Net::Endpoint server_endpoint{ 0, Net::serverPort };
+
+	if (udp_port >= 0) {
+#if DD_UDP
+		std::unique_ptr<Net::UdpTransport> udp(new Net::UdpTransport(uint16_t(udp_port)));
+		if (!udp->isOpen()) {
+			printf("Couldn't open UDP port %d\n", udp_port);
+			return 1;
+		}
+		transport = std::move(udp);
+		server_endpoint = Net::Endpoint{ INADDR_LOOPBACK, uint16_t(udp_port) };
+#else
+		printf("UDP isn't supported on this platform\n");
+		return 1;
+#endif
+	}
+	else {
+		transport.reset(new Net::LoopbackTransport(loopback, Net::serverPort));
+	}
+
+	Server server(settings, *level, *transport, session_count, bots, snapshot_interval, seed);
+
+	for (int i = 0; i < std::min(spectated, session_count); ++i) {
+#if DD_SHARED_MEMORY
+		HostedSession& hosted = *server.sessions.at(i);
+		hosted.spectator.reset(new Spectator::Publisher(hosted.id, *level));
+		if (!hosted.spectator->isOpen()) {
+			printf("Couldn't create the shared memory of session %u\n", hosted.id);
+			return 1;
+		}
+#else
+		printf("Spectating isn't supported on this platform\n");
+		return 1;
+#endif
+	}
+
+	std::vector<SimulatedClient> clients(client_count);
+	for (int i = 0; i < client_count; ++i) {
+		SimulatedClient& client = clients.at(i);
+		client.server = server_endpoint;
+		client.randomGenerator.seed(seed + unsigned(i));
+
+		if (udp_port >= 0) {
+#if DD_UDP
+			client.transport.reset(new Net::UdpTransport(0));
+#endif
+		}
+		else {
+			client.transport.reset(new Net::LoopbackTransport(loopback, uint16_t(Net::serverPort + 1 + i)));
+		}
+	}
+
+	printf("%d sessions (%d bots each) on %d threads at %.0f ticks/s, %d clients over %s, for %.0f s\n", session_count, bots, thread_count,
+		settings.tickRate, client_count, udp_port >= 0 ? "UDP" : "loopback", duration);
+
+	const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / settings.tickRate));
+	const Clock::time_point start = Clock::now();
+	const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(duration));
+
+	{
+		DeadlineScheduler scheduler(thread_count, [&server](const size_t index, const Clock::time_point deadline) { server.tick(index, deadline); });
+
+		// Spread over one period, so that the sessions don't all become due at the same time
+		for (int i = 0; i < session_count; ++i) {
+			scheduler.add(size_t(i), start + period * i / std::max(session_count, 1), period);
+		}
+
+		std::atomic<bool> clients_running{ true };
+		std::thread client_thread([&clients, &clients_running]() {
+			while (clients_running.load()) {
+				const Clock::time_point now = Clock::now();
+				for (SimulatedClient& client : clients) {
+					client.update(now);
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(33));
+			}
+		});
+
+		while (Clock::now() < end) {
+			server.receive();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		clients_running.store(false);
+		client_thread.join();
+		scheduler.stop();
+	}
+
+	const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+	uint64_t ticks = 0;
+	uint64_t overruns = 0;
+	int overrun_sessions = 0;
+	int matches = 0;
+	double tick_seconds = 0;
+	double max_lateness = 0;
+	for (const std::unique_ptr<HostedSession>& hosted : server.sessions) {
+		ticks += hosted->ticks;
+		overruns += hosted->overruns;
+		overrun_sessions += hosted->overruns > 0 ? 1 : 0;
+		matches += hosted->matches;
+		tick_seconds += hosted->tickSeconds;
+		max_lateness = std::max(max_lateness, hosted->maxLateness);
+	}
+
+	int joined_clients = 0;
+	uint64_t snapshots = 0;
+	for (const SimulatedClient& client : clients) {
+		joined_clients += client.playerIndex >= 0 ? 1 : 0;
+		snapshots += client.snapshots;
+	}
+
+	const double expected_ticks = elapsed * settings.tickRate * session_count;
+	printf("%llu ticks (%.1f%% of the schedule), %.1f us per tick, %d matches finished\n", (unsigned long long)ticks,
+		expected_ticks > 0 ? 100.0 * double(ticks) / expected_ticks : 0.0, ticks > 0 ? tick_seconds / double(ticks) * 1e6 : 0.0, matches);
+	printf("%llu overruns in %d of %d sessions, worst lateness %.2f ms\n", (unsigned long long)overruns, overrun_sessions, session_count, max_lateness * 1000.0);
+	printf("%d of %d clients joined, %llu snapshots received\n", joined_clients, client_count, (unsigned long long)snapshots);
+
+	return 0;
+}
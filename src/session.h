@@ -0,0 +1,1314 @@
+#pragma once
+
+#include <raylib.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <list>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtx/compatibility.hpp>
+#include <glm/gtx/rotate_vector.hpp>
+#include "settings.h"
+#include "content.h"
+#include "actors.h"
+#include "level.h"
+#include "profiler.h"
+#include "allocation.h"
+#include "timer_wheel.h"
+#include "weapons.h"
+#include "telemetry.h"
+#include "influence.h"
+#include "integrity.h"
+#include "visibility.h"
+
+// Circular blast area, stored as the half width of each row from -radius to +radius
+struct BlastStencil {
+	int radius;
+	std::vector<int> rowHalfWidths;
+
+	BlastStencil(const int _radius) : radius(_radius) {
+		for (int dy = -radius; dy <= radius; ++dy) {
+			int half_width = 0;
+			while ((half_width + 1) * (half_width + 1) + dy * dy <= radius * radius) {
+				++half_width;
+			}
+			rowHalfWidths.push_back(half_width);
+		}
+	}
+
+	bool overlaps(const glm::ivec2& center, const Bounds& bounds) const {
+		// The cell of the bounds nearest to the center is inside the stencil if any cell is
+		const glm::ivec2 nearest = glm::clamp(center, bounds.position, bounds.position + bounds.size - glm::ivec2(1, 1));
+		const glm::ivec2 delta = nearest - center;
+		return std::abs(delta.y) <= radius && std::abs(delta.x) <= rowHalfWidths.at(delta.y + radius);
+	}
+};
+
+class CameraShake
+{
+public:
+	const Settings& settings;
+
+	CameraShake(const Settings& _settings) : settings(_settings) {
+	}
+
+	void shake(const double now) {
+		if (now >= startTime && now < endTime) {
+			return;
+		}
+
+		startTime = now;
+		endTime = startTime + settings.cameraShakeTime;
+	}
+
+	void reset() {
+		startTime = -1;
+		endTime = 0;
+	}
+
+	void updateCamera(Camera2D& camera, const double now) {
+		const double progress = (now - startTime) / (endTime - startTime);
+		if (progress >= 0 && progress < 1) {
+			const float angle = glm::radians(float(progress) * 360);
+			const float dx = std::floor(std::cos(angle) * settings.cameraShakeStrength);
+			const float dy = std::floor(std::sin(angle) * settings.cameraShakeStrength);
+			camera.target = Vector2{ dx, dy };
+		}
+		else {
+			camera.target = Vector2{ 0, 0 };
+		}
+	}
+
+private:
+
+	double startTime = -1;
+	double endTime = 0;
+};
+
+class Session {
+public:
+	// Runs on the timer wheel, which ticks timerTicksPerSecond times per second of session time
+	struct Timer
+	{
+		enum TimerType {
+			PlayerRespawn,
+			ItemRespawn,
+			WeaponReady,
+			ProjectileExpiry,
+		};
+
+		TimerType type;
+
+		int playerIndex;
+
+		ItemType itemType;
+		Bounds itemBounds;
+
+		PooledList<Projectile>::iterator projectile;
+	};
+
+	static constexpr double timerTicksPerSecond = 120.0;
+
+	struct SoundEvent
+	{
+		enum SoundType {
+			Weapon,
+			Reload,
+		};
+
+		SoundType type;
+		int soundIndex;
+	};
+
+	struct SweepHit
+	{
+		glm::ivec2 position;
+		float time;
+	};
+
+	const Settings& settings;
+	Level level;
+	NodePool nodePool{ 256 };
+	FrameArena frameArena{ 16 * 1024 };
+	std::list<Player> players;
+	PooledList<Item> items{ PoolAllocator<Item>(nodePool) };
+	std::array<PooledList<Projectile>, weaponTypeCount> projectiles{ // One bucket per WeaponType
+		PooledList<Projectile>(PoolAllocator<Projectile>(nodePool)),
+		PooledList<Projectile>(PoolAllocator<Projectile>(nodePool)),
+		PooledList<Projectile>(PoolAllocator<Projectile>(nodePool)),
+	};
+	TimerWheel<Timer> timers{ 256 };
+	std::vector<BlastStencil> blastStencils;
+	std::vector<glm::ivec2> sightLine;
+	std::vector<SoundEvent> soundEvents; // Emitted by the last update, for the audio stage
+	std::vector<glm::ivec2> destroyedTiles; // Destroyed by the last update, for the debris particles
+	std::mt19937 randomGenerator;
+	CameraShake cameraShake;
+	InfluenceMap influence;
+	StructuralIntegrity integrity;
+	Visibility visibility;
+	std::array<int, weaponTypeCount> killsByWeapon{};
+	Telemetry* telemetry = nullptr; // Optional, owned by the caller
+
+	double time = 0;
+	double tickAccumulator = 0; // Frame time not simulated yet, less than a tick
+
+	Session(const Settings& _settings, const Level& _level, const unsigned seed = std::random_device()()) : settings(_settings), level(_level), randomGenerator(seed), cameraShake(settings), influence(level.width, level.height), integrity(level), visibility(level) {
+		soundEvents.reserve(64);
+		destroyedTiles.reserve(1024);
+
+		for (const WeaponSettings& weapon_settings : settings.weapons) {
+			blastStencils.emplace_back(weapon_settings.blastRadius);
+		}
+
+		// Longest line rasterizeLine can produce inside the level
+		sightLine.reserve(2 * (level.width + level.height) + 1);
+
+		for (const Level::ItemSpawn& spawn : level.itemSpawns) {
+			Bounds bounds{ spawn.position, glm::ivec2(4,4) };
+			Item item(bounds, spawn.type);
+			items.emplace_back(std::move(item));
+		}
+	}
+
+	glm::ivec2 findRespawnPosition() {
+		ArenaVector<int> spawn_indices{ ArenaAllocator<int>(frameArena) };
+		spawn_indices.reserve(level.playerSpawns.size());
+		for (int i = 0; i < level.playerSpawns.size(); ++i) {
+			spawn_indices.push_back(i);
+		}
+
+		std::shuffle(spawn_indices.begin(), spawn_indices.end(), randomGenerator);
+
+		for (int spawn_index : spawn_indices) {
+			const glm::ivec2 position = level.playerSpawns.at(spawn_index);
+			Bounds bounds{ position, glm::ivec2(4,4) };
+			bool occupied = false;
+
+			for (const Player& other_player : players) {
+				if (other_player.health > 0 && collide(bounds, other_player.bounds)) {
+					occupied = true;
+					break;
+				}
+			}
+
+			if (!occupied) {
+				return position;
+			}
+		}
+
+		// Every spawn is occupied, overlapping a drone is better than leaving the level
+		return level.playerSpawns.at(spawn_indices.front());
+	}
+
+	// Plays the same match again with the same players: the level tiles are restored from the level the session was
+	// created from, into the storage and texture it already has, and nothing is loaded or allocated
+	void restart(const Level& source) {
+		frameArena.reset();
+		level.restore(source);
+
+		for (PooledList<Projectile>& bucket : projectiles) {
+			bucket.clear();
+		}
+
+		items.clear();
+		for (const Level::ItemSpawn& spawn : level.itemSpawns) {
+			Bounds bounds{ spawn.position, glm::ivec2(4,4) };
+			Item item(bounds, spawn.type);
+			items.emplace_back(std::move(item));
+		}
+
+		timers.reset();
+		soundEvents.clear();
+		destroyedTiles.clear();
+		killsByWeapon.fill(0);
+		influence.clear();
+		integrity.reset(level);
+		visibility.reset(level);
+		cameraShake.reset();
+		time = 0;
+		tickAccumulator = 0;
+
+		// Respawned one after the other, so that they don't pick the same spawn
+		for (Player& player : players) {
+			player.health = 0;
+			player.input = PlayerInput{};
+			player.flankDirection = glm::ivec2(0, 0);
+			player.flankTicks = 0;
+		}
+
+		for (Player& player : players) {
+			player.bounds.position = findRespawnPosition();
+			player.subpixelPosition = player.bounds.position;
+			player.previousPosition = player.bounds.position;
+			player.health = settings.playerMaxHealth;
+			player.score = 0;
+			player.kills = 0;
+			player.weaponReady = true;
+			player.weapon.reset();
+			player.ammo = 0;
+		}
+	}
+
+	// Same, with the random generator seeded again: plays the match a new session with that seed and the same players
+	// would play
+	void restart(const Level& source, const unsigned seed) {
+		randomGenerator.seed(seed);
+		restart(source);
+	}
+
+	// Indices are the lanes of the per-player grids and arrays, past maxPlayers they would be out of bounds
+	void addPlayer(const int index, const Controller controller) {
+		if (index < 0 || index >= Settings::maxPlayers || players.size() >= size_t(Settings::maxPlayers)) {
+			throw std::out_of_range("Session::addPlayer: a session has at most Settings::maxPlayers players");
+		}
+
+		const glm::ivec2 position = findRespawnPosition();
+		Bounds bounds{ position, glm::ivec2(4,4) };
+		Player player(bounds, index, controller, settings.playerMaxHealth);
+		players.emplace_back(std::move(player));
+	}
+
+	static bool inLevel(const glm::ivec2& point, const Level& level) {
+		return point.x >= 0 && point.x < level.width && point.y >= 0 && point.y < level.height;
+	}
+
+	static bool collide(const Bounds& bounds0, const Bounds& bounds1) {
+		const glm::ivec2 intersect_min = glm::max(bounds0.position, bounds1.position);
+		const glm::ivec2 intersect_max = glm::min(bounds0.position + bounds0.size, bounds1.position + bounds1.size);
+		const glm::ivec2 intersect_size = intersect_max - intersect_min;
+		return intersect_size.x > 0 && intersect_size.y > 0;
+	}
+
+	static bool collide(const Bounds& bounds, const Level& level) {
+		for (int i = bounds.position.y; i < bounds.position.y + bounds.size.y; ++i) {
+			for (int j = bounds.position.x; j < bounds.position.x + bounds.size.x; ++j) {
+				if (inLevel(glm::ivec2(j, i), level) && level.tile(j, i).solidity > 0) {
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	static bool collide(const glm::ivec2& point, const Bounds& bounds) {
+		return point.x >= bounds.position.x && point.x < bounds.position.x + bounds.size.x &&
+			point.y >= bounds.position.y && point.y < bounds.position.y + bounds.size.y;
+	}
+
+	static bool collide(const glm::ivec2& point, const Level& level) {
+		return inLevel(point, level) && level.tile(point.x, point.y).solidity > 0;
+	}
+
+	// Earliest time in [0, 1] at which the segment enters the bounds
+	static std::optional<float> sweep(const glm::vec2& segment_start, const glm::vec2& segment_end, const Bounds& bounds) {
+		const glm::vec2 delta = segment_end - segment_start;
+		const glm::vec2 bounds_min(bounds.position);
+		const glm::vec2 bounds_max(bounds.position + bounds.size);
+
+		float enter_time = 0.0f;
+		float exit_time = 1.0f;
+
+		for (int axis = 0; axis < 2; ++axis) {
+			if (delta[axis] == 0.0f) {
+				if (segment_start[axis] < bounds_min[axis] || segment_start[axis] >= bounds_max[axis]) {
+					return std::nullopt;
+				}
+			}
+			else {
+				float time0 = (bounds_min[axis] - segment_start[axis]) / delta[axis];
+				float time1 = (bounds_max[axis] - segment_start[axis]) / delta[axis];
+				if (time0 > time1) {
+					std::swap(time0, time1);
+				}
+
+				enter_time = std::max(enter_time, time0);
+				exit_time = std::min(exit_time, time1);
+			}
+		}
+
+		if (enter_time > exit_time) {
+			return std::nullopt;
+		}
+
+		return enter_time;
+	}
+
+	// Walks the tiles crossed by the segment in order and returns the first solid one
+	static std::optional<SweepHit> sweep(const glm::vec2& segment_start, const glm::vec2& segment_end, const Level& level) {
+		const glm::vec2 delta = segment_end - segment_start;
+		const glm::ivec2 end_pixel(glm::floor(segment_end));
+		glm::ivec2 pixel(glm::floor(segment_start));
+
+		glm::ivec2 step(0, 0);
+		glm::vec2 next_time(FLT_MAX, FLT_MAX);
+		glm::vec2 time_per_pixel(FLT_MAX, FLT_MAX);
+
+		for (int axis = 0; axis < 2; ++axis) {
+			if (delta[axis] > 0) {
+				step[axis] = 1;
+				next_time[axis] = (float(pixel[axis] + 1) - segment_start[axis]) / delta[axis];
+				time_per_pixel[axis] = 1.0f / delta[axis];
+			}
+			else if (delta[axis] < 0) {
+				step[axis] = -1;
+				next_time[axis] = (float(pixel[axis]) - segment_start[axis]) / delta[axis];
+				time_per_pixel[axis] = -1.0f / delta[axis];
+			}
+		}
+
+		float enter_time = 0.0f;
+		while (true) {
+			if (collide(pixel, level)) {
+				return SweepHit{ pixel, enter_time };
+			}
+
+			if (pixel == end_pixel) {
+				break;
+			}
+
+			const int axis = next_time.x < next_time.y ? 0 : 1;
+			enter_time = next_time[axis];
+			pixel[axis] += step[axis];
+			next_time[axis] += time_per_pixel[axis];
+
+			// The level is a rectangle, once the segment leaves it it can't come back
+			if (enter_time > 1.0f || !inLevel(pixel, level)) {
+				break;
+			}
+		}
+
+		return std::nullopt;
+	}
+
+	static void rasterizeLine(const glm::vec2& segment_start, const glm::vec2& segment_end, std::vector<glm::ivec2>& result) {
+		// Temporary implementation
+		result.clear();
+		const int steps = std::max(int(glm::distance(segment_start, segment_end) * 2), 1);
+
+		for (int step = 0; step <= steps; step++) {
+			const glm::ivec2 position = glm::ivec2(glm::lerp(segment_start, segment_end, float(step) / float(steps)));
+			result.push_back(position);
+		}
+	}
+
+	static void updatePathfinding(Player& player, const Level& level) {
+		if (player.pathfinding.tilePaths.empty()) {
+			player.pathfinding.tilePaths.resize(level.height);
+			for (int i = 0; i < level.height; ++i) {
+				player.pathfinding.tilePaths.at(i).resize(level.width, Pathfinding::TilePath{-1, glm::ivec2(0, 0)});
+			}
+		}
+
+		for (int i = 0; i < level.height; ++i) {
+			for (int j = 0; j < level.width; ++j) {
+				player.pathfinding.tilePaths.at(i).at(j) = Pathfinding::TilePath{ -1, glm::ivec2(0, 0) };
+			}
+		}
+
+		// Every tile is queued at most once, so the queue never outgrows the level
+		std::vector<glm::ivec2>& bfsQueue = player.pathfinding.queue;
+		bfsQueue.clear();
+		bfsQueue.reserve(level.width * level.height);
+
+		player.pathfinding.tilePaths.at(player.bounds.position.y).at(player.bounds.position.x) = Pathfinding::TilePath{ 0, glm::ivec2(0, -0) };
+		bfsQueue.push_back(player.bounds.position);
+
+		for (size_t queue_head = 0; queue_head < bfsQueue.size(); ++queue_head) {
+			glm::ivec2 position = bfsQueue.at(queue_head);
+
+			const Pathfinding::TilePath& current_tilepath = player.pathfinding.tilePaths.at(position.y).at(position.x);
+
+			for (glm::ivec2 delta : { glm::ivec2(-1, 0), glm::ivec2(1, 0), glm::ivec2(0, -1), glm::ivec2(0, 1) }) {
+				Bounds new_bounds = player.bounds;
+				new_bounds.position = position + delta;
+
+				if (!inLevel(new_bounds.position, level)) {
+					continue;
+				}
+
+				Pathfinding::TilePath& next_tilepath = player.pathfinding.tilePaths.at(new_bounds.position.y).at(new_bounds.position.x);
+
+				if ((next_tilepath.shortestPath == -1 || current_tilepath.shortestPath + 1 < next_tilepath.shortestPath) && !collide(new_bounds, level)) {
+					next_tilepath.shortestPath = current_tilepath.shortestPath + 1;
+					next_tilepath.backDirection = -delta;
+					bfsQueue.push_back(new_bounds.position);
+				}
+			}
+		}
+	}
+
+	void aiPlayer(Player& player, glm::vec2& move_direction, glm::vec2& shoot_direction, bool& fire) {
+		move_direction = glm::vec2(0, 0);
+		shoot_direction = glm::vec2(0, 0);
+		fire = false;
+
+		//const int turn = int(GetTime() / 0.5f);
+		//if (player.pathfinding.tilePaths.empty() || turn == player.playerIndex) {
+		updatePathfinding(player, level);
+		//}
+
+		if (!player.weapon.has_value()) {
+			int nearest_weapon_distance = -1;
+			glm::ivec2 nearest_weapon_position(-1, -1);
+
+			for (const Item& item : items) {
+				if (item.type >= ItemType::Weapon0 && item.type <= ItemType::Weapon7) {
+					for (int i = 0; i < item.bounds.size.y; ++i) {
+						for (int j = 0; j < item.bounds.size.x; ++j) {
+							const auto& tilepath = player.pathfinding.tilePaths.at(item.bounds.position.y + i).at(item.bounds.position.x + j);
+							if (tilepath.shortestPath != -1 && (nearest_weapon_distance == -1 || tilepath.shortestPath < nearest_weapon_distance)) {
+								nearest_weapon_distance = tilepath.shortestPath;
+								nearest_weapon_position = glm::ivec2(item.bounds.position.x + j, item.bounds.position.y + i);
+							}
+						}
+					}
+
+				}
+			}
+
+			if (nearest_weapon_distance != -1) {
+				glm::ivec2 direction(0, 0);
+
+				glm::ivec2 current_position = nearest_weapon_position;
+				while (true) {
+					const auto& tile_path = player.pathfinding.tilePaths.at(current_position.y).at(current_position.x);
+					if (current_position == player.bounds.position || tile_path.shortestPath == 0) {
+						break;
+					}
+
+					direction = -tile_path.backDirection;
+					current_position = current_position + tile_path.backDirection;
+				}
+
+				if (direction != glm::ivec2(0, 0)) {
+					move_direction = glm::normalize(glm::vec2(direction));
+				}
+			}
+		}
+		else {
+			const glm::ivec2 player_center = player.bounds.position + player.bounds.size / 2;
+
+			int nearest_player_distance = -1;
+			const Player* nearest_player = nullptr;
+
+			for (const Player& other_player : players) {
+				if (player.playerIndex != other_player.playerIndex && other_player.health > 0) {
+					const auto& tile_path = player.pathfinding.tilePaths.at(other_player.bounds.position.y).at(other_player.bounds.position.x);
+
+					if (tile_path.shortestPath != -1 && (nearest_player_distance == -1 || tile_path.shortestPath < nearest_player_distance)) {
+						nearest_player_distance = tile_path.shortestPath;
+						nearest_player = &other_player;
+					}
+				}
+			}
+
+			if (nearest_player_distance != -1) {
+				bool visible = true;
+				if (settings.fogOfWar) {
+					visible = visibility.visible(player.playerIndex, nearest_player->bounds.position + nearest_player->bounds.size / 2);
+				}
+				else {
+					rasterizeLine(player_center, nearest_player->bounds.position + nearest_player->bounds.size / 2, sightLine);
+					for (const glm::ivec2& sight_point : sightLine) {
+						if (collide(sight_point, level)) {
+							visible = false;
+							break;
+						}
+					}
+				}
+
+				if (visible) {
+					shoot_direction = glm::normalize(glm::vec2(nearest_player->bounds.position + nearest_player->bounds.size / 2) - glm::vec2(player_center));
+					fire = true;
+				}
+				else {
+					glm::ivec2 direction(0, 0);
+
+					glm::ivec2 current_position = nearest_player->bounds.position;
+					while (true) {
+						const auto& tile_path = player.pathfinding.tilePaths.at(current_position.y).at(current_position.x);
+						if (current_position == player.bounds.position || tile_path.shortestPath == 0) {
+							break;
+						}
+
+						direction = -tile_path.backDirection;
+						current_position = current_position + tile_path.backDirection;
+					}
+
+					if (direction != glm::ivec2(0, 0)) {
+						move_direction = glm::normalize(glm::vec2(direction));
+					}
+				}
+			}
+		}
+
+		steer(player, move_direction);
+	}
+
+	// Dodges when the danger where the bot is goes over the threshold, towards the neighbor that has the least danger
+	// and is the least covered by the other drones, so it flanks out of their line of fire instead of backing into it.
+	// Below the threshold the bot flanks: it leaves its path for a direction within 45 degrees of it that the other
+	// drones cover clearly less, and keeps that direction for aiFlankTicks. Choosing again on every tick makes it
+	// alternate between two directions without moving.
+	void steer(Player& player, glm::vec2& move_direction) const {
+		static const std::array<glm::ivec2, 8> directions{
+			glm::ivec2(1, 0), glm::ivec2(1, 1), glm::ivec2(0, 1), glm::ivec2(-1, 1),
+			glm::ivec2(-1, 0), glm::ivec2(-1, -1), glm::ivec2(0, -1), glm::ivec2(1, -1),
+		};
+		static constexpr float flankMargin = 0.25f; // Cover a flank has to save over the path to be taken
+
+		const glm::ivec2 center = player.bounds.position + player.bounds.size / 2;
+		if (influence.dangerAt(center, player.playerIndex) > settings.aiDodgeThreshold) {
+			float best_score = FLT_MAX;
+			glm::vec2 best_direction = move_direction;
+
+			for (const glm::ivec2& direction : directions) {
+				if (collide(Bounds{ player.bounds.position + direction, player.bounds.size }, level)) {
+					continue;
+				}
+
+				const glm::vec2 unit_direction = glm::normalize(glm::vec2(direction));
+				const glm::ivec2 probe = center + direction * InfluenceMap::cellSize;
+				const float score = influence.dangerAt(probe, player.playerIndex) + 0.25f * influence.lineOfFireAt(probe, player.playerIndex)
+					- 0.1f * influence.attractionAt(probe) - 0.05f * glm::dot(unit_direction, move_direction);
+
+				if (score < best_score) {
+					best_score = score;
+					best_direction = unit_direction;
+				}
+			}
+
+			move_direction = best_direction;
+			player.flankTicks = 0;
+			return;
+		}
+
+		if (move_direction == glm::vec2(0, 0)) {
+			player.flankTicks = 0;
+			return;
+		}
+
+		// Kept while it doesn't go back against the path, which turns to bring the bot back as soon as it leaves it
+		if (player.flankTicks > 0) {
+			--player.flankTicks;
+			const glm::vec2 flank = glm::normalize(glm::vec2(player.flankDirection));
+			if (glm::dot(flank, move_direction) >= 0 && !collide(Bounds{ player.bounds.position + player.flankDirection, player.bounds.size }, level)) {
+				move_direction = flank;
+				return;
+			}
+			player.flankTicks = 0;
+		}
+
+		const auto cover = [&](const glm::ivec2& direction) {
+			const glm::ivec2 probe = center + direction * InfluenceMap::cellSize;
+			return influence.lineOfFireAt(probe, player.playerIndex) - 0.1f * influence.attractionAt(probe);
+		};
+
+		const glm::ivec2 path_direction(glm::round(move_direction));
+		float best_cover = cover(path_direction) - flankMargin;
+		std::optional<glm::ivec2> flank;
+
+		for (const glm::ivec2& direction : directions) {
+			if (direction == path_direction || glm::dot(glm::normalize(glm::vec2(direction)), move_direction) < 0.7f ||
+				collide(Bounds{ player.bounds.position + direction, player.bounds.size }, level)) {
+				continue;
+			}
+
+			const float direction_cover = cover(direction);
+			if (direction_cover < best_cover) {
+				best_cover = direction_cover;
+				flank = direction;
+			}
+		}
+
+		if (flank.has_value()) {
+			player.flankDirection = *flank;
+			player.flankTicks = settings.aiFlankTicks;
+			move_direction = glm::normalize(glm::vec2(*flank));
+		}
+	}
+
+	// Rebuilds the grids the bots steer with, once per tick for all of them
+	void updateInfluence(const float frame_time) {
+		PROFILE_SCOPE("Session::influence");
+
+		influence.beginTick(std::exp2(-frame_time / (settings.aiDangerLookahead * 0.5f)));
+
+		for (const PooledList<Projectile>& bucket : projectiles) {
+			for (const Projectile& projectile : bucket) {
+				const WeaponSettings& weapon_settings = settings.weapons.at(projectile.fromWeapon);
+				const float speed = glm::length(projectile.subpixelVelocity);
+				if (speed <= 0) {
+					continue;
+				}
+
+				// Along the path the projectile will fly through, fading with the time it takes to get there
+				const float amount = weapon_settings.projectileDamage / settings.playerMaxHealth;
+				const float step_time = float(InfluenceMap::cellSize) / speed;
+				const int steps = std::max(int(settings.aiDangerLookahead / step_time), 1);
+
+				glm::vec2 position = projectile.subpixelPosition;
+				glm::ivec2 tile(position);
+				for (int i = 0; i < steps; ++i) {
+					tile = glm::ivec2(glm::floor(position));
+					if (!inLevel(tile, level) || collide(tile, level)) {
+						break;
+					}
+
+					influence.addDanger(tile, projectile.ownerPlayerIndex, amount * (1.0f - float(i) / float(steps)));
+					position += projectile.subpixelVelocity * step_time;
+				}
+
+				if (weapon_settings.blastRadius > 0) {
+					influence.addBlast(tile, projectile.ownerPlayerIndex, weapon_settings.blastRadius, amount);
+				}
+			}
+		}
+
+		for (const Player& player : players) {
+			if (player.health <= 0 || !player.weapon.has_value()) {
+				continue;
+			}
+
+			const WeaponSettings& weapon_settings = settings.weapons.at(*player.weapon);
+			const float range = std::min(weapon_settings.projectileSpeed * std::min(weapon_settings.projectileLife, 1.0f), float(level.width + level.height));
+			const glm::vec2 center = glm::vec2(player.bounds.position + player.bounds.size / 2);
+
+			const int rays = 16;
+			for (int i = 0; i < rays; ++i) {
+				const float angle = glm::radians(360.0f) * float(i) / float(rays);
+				const glm::vec2 direction(std::cos(angle), std::sin(angle));
+
+				for (float distance = float(InfluenceMap::cellSize); distance < range; distance += float(InfluenceMap::cellSize)) {
+					const glm::ivec2 tile(glm::floor(center + direction * distance));
+					if (!inLevel(tile, level) || collide(tile, level)) {
+						break;
+					}
+
+					influence.addLineOfFire(tile, player.playerIndex, 1.0f - distance / range);
+				}
+			}
+		}
+
+		for (const Item& item : items) {
+			influence.addAttraction(item.bounds.position + item.bounds.size / 2, 1.0f);
+		}
+
+		influence.endTick(1, 1, 4);
+	}
+
+	// The input comes from the network, so it's checked like the one of the local players is
+	static void remotePlayer(const Player& player, glm::vec2& move_direction, glm::vec2& shoot_direction, bool& fire) {
+		const PlayerInput& input = player.input;
+		const bool finite = std::isfinite(input.move.x) && std::isfinite(input.move.y) && std::isfinite(input.shoot.x) && std::isfinite(input.shoot.y);
+
+		move_direction = finite && glm::length(input.move) > 0 ? glm::normalize(input.move) : glm::vec2(0, 0);
+		shoot_direction = finite && glm::length(input.shoot) > 0 ? glm::normalize(input.shoot) : glm::vec2(0, 0);
+		fire = input.fire;
+	}
+
+	void humanPlayer(Player& player, glm::vec2& move_direction, glm::vec2& shoot_direction, bool& fire) {
+		move_direction = glm::vec2(0, 0);
+		shoot_direction = glm::vec2(0, 0);
+		fire = false;
+
+		if (IsGamepadAvailable(player.playerIndex)) {
+			const float deadzone = 0.2f;
+			{
+
+				const float axis = GetGamepadAxisMovement(player.playerIndex, GAMEPAD_AXIS_LEFT_X);
+				if (std::abs(axis) >= deadzone) {
+					move_direction.x = axis;
+				}
+			}
+
+			{
+				const float axis = GetGamepadAxisMovement(player.playerIndex, GAMEPAD_AXIS_LEFT_Y);
+				if (std::abs(axis) >= deadzone) {
+					move_direction.y = axis;
+				}
+			}
+
+			{
+				const float axis = GetGamepadAxisMovement(player.playerIndex, GAMEPAD_AXIS_RIGHT_X);
+				if (std::abs(axis) >= deadzone) {
+					shoot_direction.x = axis;
+				}
+			}
+
+			{
+				const float axis = GetGamepadAxisMovement(player.playerIndex, GAMEPAD_AXIS_RIGHT_Y);
+				if (std::abs(axis) >= deadzone) {
+					shoot_direction.y = axis;
+				}
+			}
+
+
+			fire = IsGamepadButtonDown(player.playerIndex, GAMEPAD_BUTTON_RIGHT_TRIGGER_2);
+		}
+
+		if (player.playerIndex == 0)
+		{
+			if (IsKeyDown(KEY_W)) {
+				move_direction.y = -1;
+			}
+
+			if (IsKeyDown(KEY_S)) {
+				move_direction.y = 1;
+			}
+
+			if (IsKeyDown(KEY_A)) {
+				move_direction.x = -1;
+			}
+
+			if (IsKeyDown(KEY_D)) {
+				move_direction.x = 1;
+			}
+
+			if (IsKeyDown(KEY_UP)) {
+				shoot_direction.y = -1;
+				fire = true;
+			}
+
+			if (IsKeyDown(KEY_DOWN)) {
+				shoot_direction.y = 1;
+				fire = true;
+			}
+
+			if (IsKeyDown(KEY_LEFT)) {
+				shoot_direction.x = -1;
+				fire = true;
+			}
+
+			if (IsKeyDown(KEY_RIGHT)) {
+				shoot_direction.x = 1;
+				fire = true;
+			}
+		}
+
+		if (glm::length(move_direction) > 0) {
+			move_direction = glm::normalize(move_direction);
+		}
+
+		if (glm::length(shoot_direction) > 0) {
+			shoot_direction = glm::normalize(shoot_direction);
+		}
+	}
+
+	// Damages the tile and the players at the hit position, or everything within the blast radius for weapons with blast
+	template<WeaponType Type>
+	void applyHit(const Projectile& projectile, const glm::ivec2& hit) {
+		PROFILE_SCOPE("Session::hit");
+
+		const WeaponSettings& weapon_settings = settings.weapons.at(Type);
+
+		if (hasBlast<Type>(weapon_settings)) {
+			const BlastStencil& stencil = blastStencils.at(Type);
+
+			for (int dy = -stencil.radius; dy <= stencil.radius; ++dy) {
+				const int y = hit.y + dy;
+				if (y < 0 || y >= level.height) {
+					continue;
+				}
+
+				const int half_width = stencil.rowHalfWidths.at(dy + stencil.radius);
+				const int x_min = std::max(hit.x - half_width, 0);
+				const int x_max = std::min(hit.x + half_width, level.width - 1);
+				if (x_min <= x_max && level.damageRow(y, x_min, x_max, weapon_settings.projectileDamage, destroyedTiles)) {
+					level.textureDirty = true;
+				}
+			}
+
+			for (Player& player : players) {
+				if (player.health > 0 && stencil.overlaps(hit, player.bounds)) {
+					damagePlayer(player, weapon_settings.projectileDamage, projectile.ownerPlayerIndex, Type);
+				}
+			}
+		}
+		else {
+			if (inLevel(hit, level) && level.damageRow(hit.y, hit.x, hit.x, weapon_settings.projectileDamage, destroyedTiles)) {
+				level.textureDirty = true;
+			}
+
+			for (Player& player : players) {
+				if (player.health > 0 && collide(hit, player.bounds)) {
+					damagePlayer(player, weapon_settings.projectileDamage, projectile.ownerPlayerIndex, Type);
+				}
+			}
+		}
+	}
+
+	void damagePlayer(Player& player, const float damage, const int shooter_index, const WeaponType weapon_type) {
+		player.health -= damage;
+		recordTelemetry(TelemetryEvent::Hit, shooter_index, player.playerIndex, weapon_type, damage);
+
+		if (player.health <= 0) {
+			player.weapon.reset();
+			killsByWeapon.at(weapon_type) += 1;
+			recordTelemetry(TelemetryEvent::Kill, shooter_index, player.playerIndex, weapon_type, 0);
+
+			auto shooter = std::find_if(players.begin(), players.end(), [shooter_index](const Player& player) { return player.playerIndex == shooter_index; });
+			if (player.playerIndex == shooter->playerIndex) {
+				shooter->score -= 1;
+			}
+			else {
+				shooter->score += 1;
+				shooter->kills += 1;
+			}
+
+			Timer respawn;
+			respawn.type = Timer::PlayerRespawn;
+			respawn.playerIndex = player.playerIndex;
+			scheduleTimer(settings.respawnTime, respawn);
+		}
+	}
+
+	// Steps the simulation by as many fixed ticks as fit in the frame time, and returns how many.
+	// The sound events and destroyed tiles of all of them are kept for the frame.
+	int advance(const float frame_time) {
+		soundEvents.clear();
+		destroyedTiles.clear();
+		recordTelemetry(TelemetryEvent::Frame, TelemetryEvent::none, TelemetryEvent::none, TelemetryEvent::none, frame_time);
+
+		const double tick_time = 1.0 / settings.tickRate;
+		tickAccumulator += frame_time;
+
+		int ticks = 0;
+		while (tickAccumulator >= tick_time && ticks < settings.maxTicksPerFrame) {
+			step(float(tick_time));
+			tickAccumulator -= tick_time;
+			++ticks;
+		}
+
+		tickAccumulator = std::min(tickAccumulator, tick_time);
+		return ticks;
+	}
+
+	// How far rendering is between the last two ticks, from 0 to 1
+	float interpolation() const {
+		return float(std::min(tickAccumulator * settings.tickRate, 1.0));
+	}
+
+	// Steps the simulation by exactly frame_time, used by the tools that drive the session with their own tick
+	void update(const float frame_time) {
+		soundEvents.clear();
+		destroyedTiles.clear();
+		recordTelemetry(TelemetryEvent::Frame, TelemetryEvent::none, TelemetryEvent::none, TelemetryEvent::none, frame_time);
+		step(frame_time);
+	}
+
+	void step(const float frame_time) {
+		PROFILE_SCOPE("Session::update");
+
+		frameArena.reset();
+		time += frame_time;
+		const size_t destroyed_before = destroyedTiles.size();
+
+		for (Player& player : players) {
+			player.previousPosition = player.bounds.position;
+		}
+
+		for (PooledList<Projectile>& bucket : projectiles) {
+			for (Projectile& projectile : bucket) {
+				projectile.previousPosition = projectile.bounds.position;
+			}
+		}
+
+		// Only the bots read the grids
+		if (std::any_of(players.begin(), players.end(), [](const Player& player) { return player.controller == Controller::Bot; })) {
+			updateInfluence(frame_time);
+		}
+
+		for (Player& player : players) {
+			if (player.health <= 0) {
+				continue;
+			}
+
+			glm::vec2 move_direction(0, 0);
+			glm::vec2 shoot_direction(0, 0);
+			bool fire = false;
+
+			{
+				PROFILE_SCOPE("Session::ai");
+
+				if (player.controller == Controller::Bot) {
+					aiPlayer(player, move_direction, shoot_direction, fire);
+				}
+				else if (player.controller == Controller::Remote) {
+					remotePlayer(player, move_direction, shoot_direction, fire);
+				}
+				else {
+					humanPlayer(player, move_direction, shoot_direction, fire);
+				}
+			}
+
+			{
+				PROFILE_SCOPE("Session::movement");
+
+				glm::vec2 new_subpixel_position = player.subpixelPosition + move_direction * settings.playerSpeed * frame_time;
+				Bounds new_bounds{ glm::ivec2(new_subpixel_position), player.bounds.size };
+
+				if (!collide(new_bounds, level)) {
+					player.subpixelPosition = new_subpixel_position;
+					player.bounds = new_bounds;
+				}
+			}
+
+			if (player.weapon.has_value()) {
+				const WeaponSettings& weapon_settings = settings.weapons.at(*player.weapon);
+				if (fire && glm::length(shoot_direction) > 0.5f && player.ammo > 0 && player.weaponReady) {
+					switch (*player.weapon) {
+					case WeaponType::MachineGun:
+						fireProjectiles<WeaponType::MachineGun>(player, shoot_direction);
+						break;
+					case WeaponType::Shotgun:
+						fireProjectiles<WeaponType::Shotgun>(player, shoot_direction);
+						break;
+					case WeaponType::RocketLauncher:
+						fireProjectiles<WeaponType::RocketLauncher>(player, shoot_direction);
+						break;
+					}
+
+					player.ammo -= 1;
+					if (player.ammo == 0) {
+						player.weapon.reset();
+					}
+
+					soundEvents.push_back(SoundEvent{ SoundEvent::Weapon, weapon_settings.soundIndex });
+
+					player.weaponReady = false;
+
+					Timer weapon_ready;
+					weapon_ready.type = Timer::WeaponReady;
+					weapon_ready.playerIndex = player.playerIndex;
+					scheduleTimer(weapon_settings.shootDelay, weapon_ready);
+				}
+			}
+
+			for (auto item_iter = items.begin(); item_iter != items.end(); ++item_iter) {
+				if (collide(player.bounds, item_iter->bounds)) {
+					if (item_iter->type >= ItemType::Weapon0 && item_iter->type <= ItemType::Weapon7) {
+						const WeaponType weapon_type = WeaponType(item_iter->type - ItemType::Weapon0);
+						player.weapon = weapon_type;
+						player.ammo = settings.weapons.at(*player.weapon).maxAmmo;
+						recordTelemetry(TelemetryEvent::Pickup, player.playerIndex, TelemetryEvent::none, weapon_type, 0);
+
+						soundEvents.push_back(SoundEvent{ SoundEvent::Reload, 0 });
+					}
+
+					Timer respawn;
+					respawn.type = Timer::ItemRespawn;
+					respawn.itemType = item_iter->type;
+					respawn.itemBounds = item_iter->bounds;
+					scheduleTimer(settings.itemSpawnDelay, respawn);
+
+					item_iter = items.erase(item_iter);
+					break;
+				}
+			}
+		}
+
+		updateProjectiles<WeaponType::MachineGun>(frame_time);
+		updateProjectiles<WeaponType::Shotgun>(frame_time);
+		updateProjectiles<WeaponType::RocketLauncher>(frame_time);
+
+		if (settings.collapseFloatingTerrain) {
+			integrity.collapse(level, destroyedTiles, destroyed_before);
+		}
+
+		updateTimers();
+		updateVisibility(destroyed_before);
+
+		if (destroyedTiles.size() > destroyed_before) {
+			recordTelemetry(TelemetryEvent::TilesDestroyed, TelemetryEvent::none, TelemetryEvent::none, TelemetryEvent::none, float(destroyedTiles.size() - destroyed_before));
+		}
+	}
+
+	void recordTelemetry(const TelemetryEvent::Type type, const int player_index, const int other_index, const int weapon, const float value) {
+		if (telemetry != nullptr) {
+			telemetry->record(TelemetryEvent{ type, int8_t(player_index), int8_t(other_index), int8_t(weapon), float(time), value });
+		}
+	}
+
+	TimerHandle scheduleTimer(const double delay, const Timer& timer) {
+		return timers.schedule(timers.currentTick() + uint64_t(std::ceil(delay * timerTicksPerSecond)), timer);
+	}
+
+	template<WeaponType Type>
+	void fireProjectiles(const Player& player, const glm::vec2& shoot_direction) {
+		const WeaponSettings& weapon_settings = settings.weapons.at(Type);
+		const glm::ivec2 projectile_position = player.bounds.position + player.bounds.size / 2;
+		const bool spread = hasSpread<Type>(weapon_settings);
+		const int projectile_count = spread ? weapon_settings.projectileCount : 1;
+		recordTelemetry(TelemetryEvent::Shot, player.playerIndex, TelemetryEvent::none, Type, float(projectile_count));
+
+		for (int i = 0; i < projectile_count; ++i) {
+			glm::vec2 velocity = shoot_direction * weapon_settings.projectileSpeed;
+			if (spread) {
+				const float angle_random = (float(i) / weapon_settings.projectileCount) * 2 - 1;
+				const float angle = glm::radians(angle_random * weapon_settings.projectileSpread);
+				velocity = glm::rotate(shoot_direction, angle) * weapon_settings.projectileSpeed;
+			}
+
+			PooledList<Projectile>& bucket = projectiles.at(Type);
+			Projectile projectile(Bounds{ projectile_position, glm::ivec2(1,1) }, player.playerIndex, Type, velocity);
+			bucket.emplace_back(std::move(projectile));
+
+			if (weapon_settings.projectileLife < FLT_MAX) {
+				Timer expiry;
+				expiry.type = Timer::ProjectileExpiry;
+				expiry.projectile = std::prev(bucket.end());
+				expiry.projectile->expiryTimer = scheduleTimer(weapon_settings.projectileLife, expiry);
+			}
+		}
+	}
+
+	template<WeaponType Type>
+	PooledList<Projectile>::iterator eraseProjectile(PooledList<Projectile>::iterator projectile) {
+		if (hasExpiry<Type>(settings.weapons.at(Type))) {
+			timers.cancel(projectile->expiryTimer);
+		}
+		return projectiles.at(Type).erase(projectile);
+	}
+
+	template<WeaponType Type>
+	void updateProjectiles(const float frame_time) {
+		PROFILE_SCOPE("Session::projectiles");
+
+		PooledList<Projectile>& bucket = projectiles.at(Type);
+		for (auto projectile_iter = bucket.begin(); projectile_iter != bucket.end();) {
+			Projectile& projectile = *projectile_iter;
+			const glm::vec2 start_position = projectile.subpixelPosition;
+
+			if (!inLevel(start_position, level)) {
+				projectile_iter = eraseProjectile<Type>(projectile_iter);
+				continue;
+			}
+
+			const glm::vec2 end_position = projectile.subpixelPosition + projectile.subpixelVelocity * frame_time;
+			std::optional<SweepHit> hit = sweep(start_position, end_position, level);
+
+			for (const Player& player : players) {
+				if (player.health <= 0) {
+					continue;
+				}
+
+				if (projectile.ownerPlayerIndex == player.playerIndex) {
+					continue;
+				}
+
+				const std::optional<float> time = sweep(start_position, end_position, player.bounds);
+				if (time.has_value() && (!hit.has_value() || *time < hit->time)) {
+					const glm::ivec2 pixel(glm::floor(glm::lerp(start_position, end_position, *time)));
+					const glm::ivec2 position = glm::clamp(pixel, player.bounds.position, player.bounds.position + player.bounds.size - glm::ivec2(1, 1));
+					hit = SweepHit{ position, *time };
+				}
+			}
+
+			if (hit.has_value()) {
+				applyHit<Type>(projectile, hit->position);
+
+				if (settings.weapons.at(Type).shakeOnHit) {
+					cameraShake.shake(time);
+				}
+
+				projectile_iter = eraseProjectile<Type>(projectile_iter);
+			}
+			else {
+				projectile.bounds.position = end_position;
+				projectile.subpixelPosition = end_position;
+				++projectile_iter;
+			}
+		}
+	}
+
+	// Views of the living drones, only while the fog of war is on
+	void updateVisibility(const size_t destroyed_before) {
+		if (!settings.fogOfWar) {
+			visibility.invalidate();
+			return;
+		}
+
+		PROFILE_SCOPE("Session::visibility");
+
+		visibility.destroyTiles(level, destroyedTiles, destroyed_before);
+		for (const Player& player : players) {
+			if (player.health > 0) {
+				visibility.update(player.playerIndex, player.bounds.position + player.bounds.size / 2);
+			}
+		}
+	}
+
+	void updateTimers() {
+		PROFILE_SCOPE("Session::timers");
+
+		timers.advance(uint64_t(time * timerTicksPerSecond), [this](const Timer& timer) {
+			if (timer.type == Timer::PlayerRespawn) {
+				auto player_iter = std::find_if(players.begin(), players.end(), [index = timer.playerIndex](const Player& player) { return player.playerIndex == index; });
+				player_iter->bounds.position = findRespawnPosition();
+				player_iter->subpixelPosition = player_iter->bounds.position;
+				player_iter->previousPosition = player_iter->bounds.position;
+				player_iter->health = settings.playerMaxHealth;
+			}
+			else if (timer.type == Timer::ItemRespawn) {
+				Item item(timer.itemBounds, timer.itemType);
+				items.emplace_back(std::move(item));
+			}
+			else if (timer.type == Timer::WeaponReady) {
+				auto player_iter = std::find_if(players.begin(), players.end(), [index = timer.playerIndex](const Player& player) { return player.playerIndex == index; });
+				player_iter->weaponReady = true;
+			}
+			else if (timer.type == Timer::ProjectileExpiry) {
+				projectiles.at(timer.projectile->fromWeapon).erase(timer.projectile);
+			}
+		});
+	}
+
+	std::optional<std::vector<int>> checkEndgame() {
+
+		bool finished = false;
+		for (const Player& player : players) {
+			if (player.score == settings.scoreForWin) {
+				finished = true;
+			}
+		}
+
+		if (!finished) {
+			return std::nullopt;
+		}
+
+		ArenaVector<std::pair<int, int>> scores{ ArenaAllocator<std::pair<int, int>>(frameArena) };
+		for (const Player& player : players) {
+			scores.emplace_back(player.score, player.playerIndex);
+		}
+
+		std::vector<int> rankings;
+
+		std::sort(scores.begin(), scores.end());
+		for (auto iter = scores.rbegin(); iter != scores.rend(); ++iter) {
+			rankings.push_back(iter->second);
+		}
+
+		recordTelemetry(TelemetryEvent::MatchEnd, rankings.front(), TelemetryEvent::none, TelemetryEvent::none, 0);
+
+		return rankings;
+	}
+
+	void renderScene(const Content& content) {
+		PROFILE_SCOPE("Session::renderScene");
+
+		if (level.textureDirty) {
+			level.refreshTexture();
+			level.textureDirty = false;
+		}
+
+		DrawTexture(level.texture, 0, 0, WHITE);
+
+		// With the fog of war, the screen shows what the local players see, and everything when there are none
+		uint32_t viewers = 0;
+		if (settings.fogOfWar) {
+			for (const Player& player : players) {
+				if (player.controller == Controller::Local) {
+					viewers |= 1u << player.playerIndex;
+				}
+			}
+		}
+
+		if (viewers != 0) {
+			visibility.drawFog(viewers);
+		}
+
+		const auto seen = [&](const glm::ivec2& tile) {
+			return viewers == 0 || visibility.visibleToAny(viewers, tile);
+		};
+
+		const float alpha = interpolation();
+
+		for (const Player& player : players) {
+			if (player.health <= 0 || !(((viewers >> player.playerIndex) & 1) || seen(player.bounds.position + player.bounds.size / 2))) {
+				continue;
+			}
+
+			const glm::vec2 position = glm::mix(glm::vec2(player.previousPosition), glm::vec2(player.bounds.position), alpha);
+			DrawTextureV(content.drone, Vector2{ position.x, position.y }, settings.playerTints.at(player.playerIndex));
+		}
+
+		for (const Item& item : items) {
+			if (!seen(item.bounds.position + item.bounds.size / 2)) {
+				continue;
+			}
+
+			if (item.type == ItemType::Weapon0) {
+				DrawTexture(content.machinegun, item.bounds.position.x, item.bounds.position.y, WHITE);
+			}
+			else if (item.type == ItemType::Weapon1) {
+				DrawTexture(content.laser, item.bounds.position.x, item.bounds.position.y, WHITE);
+			}
+			else if (item.type == ItemType::Weapon2) {
+				DrawTexture(content.rocketlauncher, item.bounds.position.x, item.bounds.position.y, WHITE);
+			}
+		}
+
+		for (const PooledList<Projectile>& bucket : projectiles) {
+			for (const Projectile& projectile : bucket) {
+				if (!seen(projectile.bounds.position)) {
+					continue;
+				}
+
+				const glm::vec2 position = glm::mix(glm::vec2(projectile.previousPosition), glm::vec2(projectile.bounds.position), alpha);
+				DrawTextureV(content.pixel, Vector2{ position.x, position.y }, GRAY);
+			}
+		}
+	}
+
+	void renderUi(const Content& content) {
+		PROFILE_SCOPE("Session::renderUi");
+
+		for (const Player& player : players) {
+			static const std::array<int, Settings::maxPlayers> offsets{1, 18, 34, 51};
+
+			const int offset = offsets.at(player.playerIndex);
+			const Color tint = settings.playerTints.at(player.playerIndex);
+
+			{
+				const int score_pixels = int(float(player.score) / float(settings.scoreForWin) * 6);
+				for (int i = 0; i < score_pixels; ++i) {
+					DrawTexture(content.pixel, offset + 0, 62 - i, tint);
+					DrawTexture(content.pixel, offset + 1, 62 - i, tint);
+				}
+			}
+
+			{
+				DrawTexture(content.drone, offset + 3, 57, tint);
+
+				const int health_pixels = int(std::ceil(player.health / settings.playerMaxHealth * 4));
+				for (int i = 0; i < health_pixels; ++i) {
+					DrawTexture(content.pixel, offset + 3 + i, 62, tint);
+				}
+			}
+
+			if (player.weapon.has_value()) {
+				if (player.weapon == WeaponType::MachineGun) {
+					DrawTexture(content.machinegun, offset + 8, 57, WHITE);
+				}
+				else if (player.weapon == WeaponType::Shotgun) {
+					DrawTexture(content.laser, offset + 8, 57, WHITE);
+				}
+				else if (player.weapon == WeaponType::RocketLauncher) {
+					DrawTexture(content.rocketlauncher, offset + 8, 57, WHITE);
+				}
+
+				const int ammo_pixels = int(std::ceil(float(player.ammo) / float(settings.weapons.at(*player.weapon).maxAmmo) * 4));
+				for (int i = 0; i < ammo_pixels; ++i) {
+					DrawTexture(content.pixel, offset + 8 + i, 62, tint);
+				}
+			}
+		}
+	}
+};
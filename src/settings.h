@@ -0,0 +1,107 @@
+#pragma once
+
+#include <raylib.h>
+#include <array>
+#include <cfloat>
+
+enum WeaponType {
+	MachineGun,
+	Shotgun,
+	RocketLauncher,
+};
+
+struct WeaponSettings {
+	int maxAmmo;
+	float shootDelay;
+	float projectileSpeed;
+	float projectileDamage;
+	int projectileCount;
+	float projectileSpread;
+	float projectileLife;
+	int blastRadius;
+	bool shakeOnHit;
+	int soundIndex;
+};
+
+struct Settings {
+	float playerMaxHealth;
+	float playerSpeed;
+	float playerCrosshairSpeed;
+	float itemSpawnDelay;
+	float tileHealth;
+	int scoreForWin;
+	float respawnTime;
+	float cameraShakeStrength;
+	float cameraShakeTime;
+	int debrisPerTile;
+	float debrisSpeed;
+	float debrisGravity;
+	float debrisLife;
+	float tickRate; // Simulation ticks per second, independent of the frame rate
+	int maxTicksPerFrame; // Beyond this the simulation slows down instead of spiraling on slow machines
+	float aiDangerLookahead; // Seconds of projectile flight the bots see coming
+	float aiDodgeThreshold; // Danger over which bots stop chasing and dodge, 1 is a lethal hit
+	int aiFlankTicks; // Ticks a bot keeps a flanking direction before choosing again
+	bool collapseFloatingTerrain; // Terrain cut off from the bedrock falls apart into debris
+	bool fogOfWar; // Drones only see what's in their line of sight, the screen shows what the local players see
+	static constexpr int maxPlayers = 4; // Tints, HUD slots, influence lanes, visibility views and network slots
+	std::array<Color, maxPlayers> playerTints;
+	std::array<WeaponSettings, 3> weapons;
+
+	Settings() {
+		playerMaxHealth = 100.0f;
+		playerSpeed = 20.0f;
+		playerCrosshairSpeed = 20.0f;
+		itemSpawnDelay = 5.0f;
+		tileHealth = 10.0f;
+		scoreForWin = 20;
+		respawnTime = 3;
+		cameraShakeStrength = 1.0f;
+		cameraShakeTime = 0.5f;
+		debrisPerTile = 3;
+		debrisSpeed = 25.0f;
+		debrisGravity = 60.0f;
+		debrisLife = 0.75f;
+		tickRate = 120.0f;
+		maxTicksPerFrame = 8;
+		aiDangerLookahead = 0.5f;
+		aiDodgeThreshold = 0.1f;
+		aiFlankTicks = 30;
+		collapseFloatingTerrain = true;
+		fogOfWar = false;
+		playerTints.at(0) = RED;
+		playerTints.at(1) = YELLOW;
+		playerTints.at(2) = GREEN;
+		playerTints.at(3) = BLUE;
+		weapons.at(WeaponType::MachineGun).maxAmmo = 40;
+		weapons.at(WeaponType::MachineGun).shootDelay = 0.2f;
+		weapons.at(WeaponType::MachineGun).projectileSpeed = 50.0f;
+		weapons.at(WeaponType::MachineGun).projectileDamage = 5.0f;
+		weapons.at(WeaponType::MachineGun).projectileCount = 1;
+		weapons.at(WeaponType::MachineGun).projectileSpread = 0;
+		weapons.at(WeaponType::MachineGun).projectileLife = FLT_MAX;
+		weapons.at(WeaponType::MachineGun).blastRadius = 0;
+		weapons.at(WeaponType::MachineGun).shakeOnHit = false;
+		weapons.at(WeaponType::MachineGun).soundIndex = 0;
+		weapons.at(WeaponType::Shotgun).maxAmmo = 20;
+		weapons.at(WeaponType::Shotgun).shootDelay = 1.0f;
+		weapons.at(WeaponType::Shotgun).projectileSpeed = 50.0f;
+		weapons.at(WeaponType::Shotgun).projectileDamage = 10.0f;
+		weapons.at(WeaponType::Shotgun).projectileCount = 7;
+		weapons.at(WeaponType::Shotgun).projectileSpread = 60;
+		weapons.at(WeaponType::Shotgun).projectileLife = 1.0f;
+		weapons.at(WeaponType::Shotgun).blastRadius = 0;
+		weapons.at(WeaponType::Shotgun).shakeOnHit = false;
+		weapons.at(WeaponType::Shotgun).soundIndex = 0;
+		weapons.at(WeaponType::RocketLauncher).maxAmmo = 5;
+		weapons.at(WeaponType::RocketLauncher).shootDelay = 1.0f;
+		weapons.at(WeaponType::RocketLauncher).projectileSpeed = 50.0f;
+		weapons.at(WeaponType::RocketLauncher).projectileDamage = 50.0f;
+		weapons.at(WeaponType::RocketLauncher).projectileCount = 1;
+		weapons.at(WeaponType::RocketLauncher).projectileSpread = 0;
+		weapons.at(WeaponType::RocketLauncher).projectileLife = FLT_MAX;
+		weapons.at(WeaponType::RocketLauncher).blastRadius = 4;
+		weapons.at(WeaponType::RocketLauncher).shakeOnHit = true;
+		weapons.at(WeaponType::RocketLauncher).soundIndex = 1;
+	}
+};
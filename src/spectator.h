@@ -0,0 +1,332 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <vector>
+#include "settings.h"
+#include "level.h"
+#include "session.h"
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define DD_SHARED_MEMORY 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define DD_SHARED_MEMORY 0
+#endif
+
+// State of a running session published in a POSIX shared memory region, for viewers in other processes to watch it
+// without sockets or serialization. The publisher writes the region in place once per tick, between two increments
+// of a sequence number (a seqlock): readers copy it out and keep the copy only if the sequence was even and didn't
+// change meanwhile. The session never waits for a reader, and any number of readers can attach.
+namespace Spectator {
+	static constexpr uint32_t magic = 0x43505344; // "DSPC"
+	static constexpr uint32_t version = 1;
+	static constexpr int maxItems = 64;
+	static constexpr int maxProjectiles = 8192; // Beyond that, the rest of the tick's projectiles aren't shown
+
+	enum TileState : uint8_t {
+		Empty,
+		Solid,
+		Bedrock,
+	};
+
+	struct PlayerState {
+		int16_t x;
+		int16_t y;
+		int16_t previousX;
+		int16_t previousY;
+		float health;
+		int16_t score;
+		int16_t ammo;
+		int8_t playerIndex;
+		int8_t weapon; // -1 without one
+		uint8_t padding[2];
+	};
+
+	struct ItemState {
+		int16_t x;
+		int16_t y;
+		uint8_t type;
+		uint8_t padding[3];
+	};
+
+	struct ProjectileState {
+		int16_t x;
+		int16_t y;
+		int16_t previousX;
+		int16_t previousY;
+		int8_t weapon;
+		int8_t owner;
+		uint8_t padding[2];
+	};
+
+	// Everything written under the sequence, except the tiles
+	struct Frame {
+		uint64_t tick;
+		double time;
+		int32_t playerCount;
+		int32_t itemCount;
+		int32_t projectileCount;
+		int32_t padding;
+		std::array<PlayerState, Settings::maxPlayers> players;
+		std::array<ItemState, maxItems> items;
+		std::array<ProjectileState, maxProjectiles> projectiles;
+	};
+
+	// Start of the region, followed by the width * height TileStates of the level, row major
+	struct Header {
+		uint32_t magic; // Written last when the region is created
+		uint32_t version;
+		uint64_t size; // Of the whole region
+		int32_t width;
+		int32_t height;
+		std::atomic<uint32_t> sequence; // Odd while the publisher writes
+		std::atomic<uint32_t> open; // Cleared when the publisher goes away
+		Frame frame;
+	};
+
+	static_assert(std::atomic<uint32_t>::is_always_lock_free, "The sequence is shared between processes");
+
+	inline size_t regionSize(const int width, const int height) {
+		return sizeof(Header) + size_t(width) * height;
+	}
+
+	// Shared memory object of a session, under /dev/shm on Linux
+	inline std::array<char, 64> regionName(const uint32_t session_id) {
+		std::array<char, 64> name;
+		snprintf(name.data(), name.size(), "/destructive_drones.%u", session_id);
+		return name;
+	}
+
+#if DD_SHARED_MEMORY
+	// Simulation side, creates the region and writes into it
+	class Publisher {
+	public:
+		Publisher(const uint32_t session_id, const Level& level) : name(regionName(session_id)) {
+			size = regionSize(level.width, level.height);
+
+			const int descriptor = shm_open(name.data(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+			if (descriptor < 0) {
+				return;
+			}
+
+			void* memory = ftruncate(descriptor, off_t(size)) == 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0) : MAP_FAILED;
+			close(descriptor);
+			if (memory == MAP_FAILED) {
+				shm_unlink(name.data());
+				return;
+			}
+
+			header = new (memory) Header();
+			header->version = version;
+			header->size = size;
+			header->width = level.width;
+			header->height = level.height;
+			header->open.store(1, std::memory_order_relaxed);
+			tiles = static_cast<uint8_t*>(memory) + sizeof(Header);
+
+			std::atomic_thread_fence(std::memory_order_release);
+			header->magic = magic;
+		}
+
+		Publisher(const Publisher&) = delete;
+		Publisher& operator=(const Publisher&) = delete;
+
+		~Publisher() {
+			if (header == nullptr) {
+				return;
+			}
+
+			header->open.store(0, std::memory_order_release);
+			munmap(header, size);
+			shm_unlink(name.data());
+		}
+
+		bool isOpen() const {
+			return header != nullptr;
+		}
+
+		// Called after each tick, or after a restart. Only the tiles destroyed by the last update are written, all of
+		// them after a restart or the first time.
+		void publish(const Session& session, const uint64_t tick) {
+			if (header == nullptr || session.level.width != header->width || session.level.height != header->height) {
+				return;
+			}
+
+			const uint32_t sequence = header->sequence.load(std::memory_order_relaxed);
+			header->sequence.store(sequence + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			const Level& level = session.level;
+			if (!published || session.time < lastTime) {
+				for (int y = 0; y < level.height; ++y) {
+					const Level::Tile* row = level.row(y);
+					uint8_t* states = tiles + size_t(y) * level.width;
+					for (int x = 0; x < level.width; ++x) {
+						states[x] = row[x].bedrock ? Bedrock : (row[x].solidity > 0 ? Solid : Empty);
+					}
+				}
+			}
+			else {
+				for (const glm::ivec2& tile : session.destroyedTiles) {
+					tiles[size_t(tile.y) * level.width + tile.x] = Empty;
+				}
+			}
+			published = true;
+			lastTime = session.time;
+
+			Frame& frame = header->frame;
+			frame.tick = tick;
+			frame.time = session.time;
+
+			int player_count = 0;
+			for (const Player& player : session.players) {
+				if (player_count == Settings::maxPlayers) {
+					break;
+				}
+				frame.players[player_count++] = PlayerState{ int16_t(player.bounds.position.x), int16_t(player.bounds.position.y),
+					int16_t(player.previousPosition.x), int16_t(player.previousPosition.y), player.health, int16_t(player.score), int16_t(player.ammo),
+					int8_t(player.playerIndex), int8_t(player.weapon.has_value() ? int(*player.weapon) : -1), {} };
+			}
+			frame.playerCount = player_count;
+
+			int item_count = 0;
+			for (const Item& item : session.items) {
+				if (item_count == maxItems) {
+					break;
+				}
+				frame.items[item_count++] = ItemState{ int16_t(item.bounds.position.x), int16_t(item.bounds.position.y), uint8_t(item.type), {} };
+			}
+			frame.itemCount = item_count;
+
+			int projectile_count = 0;
+			for (const PooledList<Projectile>& bucket : session.projectiles) {
+				for (const Projectile& projectile : bucket) {
+					if (projectile_count == maxProjectiles) {
+						break;
+					}
+					frame.projectiles[projectile_count++] = ProjectileState{ int16_t(projectile.bounds.position.x), int16_t(projectile.bounds.position.y),
+						int16_t(projectile.previousPosition.x), int16_t(projectile.previousPosition.y), int8_t(projectile.fromWeapon), int8_t(projectile.ownerPlayerIndex), {} };
+				}
+			}
+			frame.projectileCount = projectile_count;
+
+			header->sequence.store(sequence + 2, std::memory_order_release);
+		}
+
+	private:
+		std::array<char, 64> name;
+		size_t size = 0;
+		Header* header = nullptr;
+		uint8_t* tiles = nullptr;
+		bool published = false;
+		double lastTime = 0;
+	};
+
+	// Viewer side, maps the region read only and copies consistent frames out of it
+	class Reader {
+	public:
+		int width = 0;
+		int height = 0;
+		Frame frame{};
+		std::vector<uint8_t> tiles;
+
+		// False until the publisher has created the region
+		bool attach(const uint32_t session_id) {
+			detach();
+
+			const std::array<char, 64> name = regionName(session_id);
+			const int descriptor = shm_open(name.data(), O_RDONLY, 0);
+			if (descriptor < 0) {
+				return false;
+			}
+
+			struct stat status;
+			void* memory = MAP_FAILED;
+			if (fstat(descriptor, &status) == 0 && size_t(status.st_size) >= sizeof(Header)) {
+				size = size_t(status.st_size);
+				memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, descriptor, 0);
+			}
+			close(descriptor);
+			if (memory == MAP_FAILED) {
+				return false;
+			}
+
+			header = static_cast<const Header*>(memory);
+			const bool valid = header->magic == magic && header->version == version && header->size == size &&
+				size == regionSize(header->width, header->height);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (!valid) {
+				detach();
+				return false;
+			}
+
+			width = header->width;
+			height = header->height;
+			tiles.resize(size_t(width) * height);
+			return true;
+		}
+
+		void detach() {
+			if (header != nullptr) {
+				munmap(const_cast<Header*>(header), size);
+				header = nullptr;
+			}
+		}
+
+		~Reader() {
+			detach();
+		}
+
+		bool isAttached() const {
+			return header != nullptr;
+		}
+
+		// The publisher went away, the region is only kept alive by this mapping
+		bool isClosed() const {
+			return header == nullptr || header->open.load(std::memory_order_acquire) == 0;
+		}
+
+		// Copies the latest frame, returns false if the publisher kept writing during every attempt
+		bool read(const int attempts = 64) {
+			if (header == nullptr) {
+				return false;
+			}
+
+			for (int attempt = 0; attempt < attempts; ++attempt) {
+				const uint32_t before = header->sequence.load(std::memory_order_acquire);
+				if (before & 1) {
+					continue;
+				}
+
+				// Only as many projectiles as the copy says there are, a torn count is caught by the sequence check
+				memcpy(&frame, &header->frame, offsetof(Frame, projectiles));
+				frame.projectileCount = std::clamp(frame.projectileCount, 0, maxProjectiles);
+				memcpy(frame.projectiles.data(), header->frame.projectiles.data(), sizeof(ProjectileState) * size_t(frame.projectileCount));
+				memcpy(tiles.data(), reinterpret_cast<const uint8_t*>(header) + sizeof(Header), tiles.size());
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (header->sequence.load(std::memory_order_relaxed) == before) {
+					frame.playerCount = std::clamp(frame.playerCount, 0, Settings::maxPlayers);
+					frame.itemCount = std::clamp(frame.itemCount, 0, maxItems);
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+	private:
+		const Header* header = nullptr;
+		size_t size = 0;
+	};
+#endif
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+// Web builds without pthreads can't start the writer, the ring is only drained when the telemetry is destroyed
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define DD_TELEMETRY_THREAD 0
+#else
+#define DD_TELEMETRY_THREAD 1
+#endif
+
+// Lock free ring between one producer and one consumer thread. The capacity is rounded up to a power of two
+// and allocated once, pushing and popping never allocate.
+template<typename T>
+class SpscRing {
+public:
+	SpscRing(const size_t capacity) {
+		size_t size = 1;
+		while (size < capacity) {
+			size *= 2;
+		}
+		slots.resize(size);
+		mask = size - 1;
+	}
+
+	// Producer side, returns false if the ring is full
+	bool push(const T& value) {
+		const size_t head = writeIndex.load(std::memory_order_relaxed);
+		if (head - cachedReadIndex > mask) {
+			cachedReadIndex = readIndex.load(std::memory_order_acquire);
+			if (head - cachedReadIndex > mask) {
+				return false;
+			}
+		}
+
+		slots[head & mask] = value;
+		writeIndex.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Producer side, pushes all of the values or none of them, returns false if they don't fit
+	bool push(const T* values, const size_t count) {
+		const size_t head = writeIndex.load(std::memory_order_relaxed);
+		if (head + count - cachedReadIndex > mask + 1) {
+			cachedReadIndex = readIndex.load(std::memory_order_acquire);
+			if (head + count - cachedReadIndex > mask + 1) {
+				return false;
+			}
+		}
+
+		for (size_t i = 0; i < count; ++i) {
+			slots[(head + i) & mask] = values[i];
+		}
+		writeIndex.store(head + count, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side, pops up to max_count values into output and returns how many
+	size_t pop(T* output, const size_t max_count) {
+		const size_t tail = readIndex.load(std::memory_order_relaxed);
+		const size_t head = writeIndex.load(std::memory_order_acquire);
+		const size_t count = std::min(head - tail, max_count);
+
+		for (size_t i = 0; i < count; ++i) {
+			output[i] = slots[(tail + i) & mask];
+		}
+
+		readIndex.store(tail + count, std::memory_order_release);
+		return count;
+	}
+
+private:
+	std::vector<T> slots;
+	size_t mask = 0;
+
+	// Each index on its own cache line, so the two threads don't invalidate each other's
+	alignas(64) std::atomic<size_t> writeIndex{ 0 };
+	size_t cachedReadIndex = 0; // Producer's last view of readIndex
+	alignas(64) std::atomic<size_t> readIndex{ 0 };
+};
+
+struct TelemetryEvent {
+	enum Type : uint8_t {
+		MatchStart, // value: players
+		Frame, // value: frame time
+		Shot, // player, weapon, value: projectiles
+		Hit, // player: shooter, other: victim, weapon, value: damage
+		Kill, // player: shooter, other: victim, weapon
+		Pickup, // player, weapon
+		TilesDestroyed, // value: tiles
+		MatchEnd, // player: winner
+	};
+
+	static constexpr int none = -1;
+
+	uint8_t type;
+	int8_t player;
+	int8_t other;
+	int8_t weapon;
+	float time; // Session time
+	float value;
+};
+
+static_assert(sizeof(TelemetryEvent) == 12, "Telemetry events are part of the log format");
+
+// Streams match events to a binary log: a header followed by raw TelemetryEvents. The simulation only pushes into
+// a ring, a writer thread drains it to the file in batches. Events that don't fit in the ring are dropped and counted,
+// recording never blocks the tick.
+class Telemetry {
+public:
+	struct Header {
+		char magic[4]; // "DDTL"
+		uint32_t version;
+	};
+
+	static constexpr uint32_t version = 1;
+
+	Telemetry(const std::filesystem::path& path, const size_t capacity = 1 << 16) : ring(capacity), batch(4096) {
+		file = fopen(path.string().c_str(), "wb");
+		if (file == nullptr) {
+			return;
+		}
+
+		Header header;
+		memcpy(header.magic, "DDTL", 4);
+		header.version = version;
+		fwrite(&header, sizeof(header), 1, file);
+
+#if DD_TELEMETRY_THREAD
+		writer = std::thread([this]() { writeLoop(); });
+#endif
+	}
+
+	Telemetry(const Telemetry&) = delete;
+	Telemetry& operator=(const Telemetry&) = delete;
+
+	~Telemetry() {
+		if (file == nullptr) {
+			return;
+		}
+
+		running.store(false, std::memory_order_release);
+#if DD_TELEMETRY_THREAD
+		writer.join();
+#else
+		writeLoop();
+#endif
+		fclose(file);
+	}
+
+	bool isOpen() const {
+		return file != nullptr;
+	}
+
+	void record(const TelemetryEvent& event) {
+		if (file != nullptr && !ring.push(event)) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	uint64_t droppedEvents() const {
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	SpscRing<TelemetryEvent> ring;
+	std::vector<TelemetryEvent> batch;
+	std::atomic<uint64_t> dropped{ 0 };
+	std::atomic<bool> running{ true };
+	FILE* file = nullptr;
+#if DD_TELEMETRY_THREAD
+	std::thread writer;
+#endif
+
+	void writeLoop() {
+		while (true) {
+			const bool stopping = !running.load(std::memory_order_acquire);
+			const size_t count = ring.pop(batch.data(), batch.size());
+			if (count > 0) {
+				fwrite(batch.data(), sizeof(TelemetryEvent), count, file);
+			}
+			else if (stopping) {
+				break;
+			}
+			else {
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+		}
+
+		fflush(file);
+	}
+};
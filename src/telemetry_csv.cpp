@@ -0,0 +1,64 @@
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "telemetry.h"
+
+// Converts a telemetry log written by the game into CSV:
+// destructive_drones_telemetry <telemetry.ddtl> [output.csv]
+// Writes to the standard output when no output is given.
+int main(int argc, char** argv) {
+	if (argc < 2 || argc > 3) {
+		printf("Usage: %s <telemetry.ddtl> [output.csv]\n", argv[0]);
+		return 1;
+	}
+
+	FILE* input = fopen(argv[1], "rb");
+	if (input == nullptr) {
+		printf("Couldn't read %s\n", argv[1]);
+		return 1;
+	}
+
+	Telemetry::Header header;
+	if (fread(&header, sizeof(header), 1, input) != 1 || memcmp(header.magic, "DDTL", 4) != 0 || header.version != Telemetry::version) {
+		printf("%s is not a telemetry log\n", argv[1]);
+		fclose(input);
+		return 1;
+	}
+
+	FILE* output = argc == 3 ? fopen(argv[2], "w") : stdout;
+	if (output == nullptr) {
+		printf("Couldn't write %s\n", argv[2]);
+		fclose(input);
+		return 1;
+	}
+
+	const std::array<const char*, 8> type_names = { "match_start", "frame", "shot", "hit", "kill", "pickup", "tiles_destroyed", "match_end" };
+
+	fprintf(output, "match,time,event,player,other,weapon,value\n");
+
+	int match = -1;
+	std::array<TelemetryEvent, 4096> batch;
+	size_t count;
+	while ((count = fread(batch.data(), sizeof(TelemetryEvent), batch.size(), input)) > 0) {
+		for (size_t i = 0; i < count; ++i) {
+			const TelemetryEvent& event = batch[i];
+			if (event.type >= type_names.size()) {
+				continue;
+			}
+
+			if (event.type == TelemetryEvent::MatchStart) {
+				++match;
+			}
+
+			fprintf(output, "%d,%.4f,%s,%d,%d,%d,%g\n", match, event.time, type_names.at(event.type), event.player, event.other, event.weapon, event.value);
+		}
+	}
+
+	fclose(input);
+	if (output != stdout) {
+		fclose(output);
+	}
+
+	return 0;
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TimerHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+};
+
+// Hierarchical timing wheel over an integer tick clock. Scheduling and cancelling are O(1), and each tick only looks
+// at the timers expiring in it, plus a cascade of one slot of the coarser levels every 64 ticks.
+// Timers live in a node array with a free list, so the steady state doesn't allocate.
+template<typename Payload>
+class TimerWheel {
+public:
+	static constexpr int slotBits = 6;
+	static constexpr int slotsPerLevel = 1 << slotBits;
+	static constexpr int levels = 4;
+	static constexpr uint64_t maxDelay = (uint64_t(1) << (slotBits * levels)) - 1;
+
+	TimerWheel(const size_t capacity) {
+		nodes.reserve(capacity);
+		slots.fill(none);
+	}
+
+	uint64_t currentTick() const {
+		return nextTick - 1;
+	}
+
+	TimerHandle schedule(const uint64_t tick, const Payload& payload) {
+		uint32_t index;
+		if (freeHead != none) {
+			index = freeHead;
+			freeHead = nodes.at(index).next;
+		}
+		else {
+			index = uint32_t(nodes.size());
+			nodes.emplace_back();
+		}
+
+		Node& node = nodes.at(index);
+		node.expiry = tick;
+		node.payload = payload;
+		node.active = true;
+		insert(index);
+
+		return TimerHandle{ index, node.generation };
+	}
+
+	// Returns false if the timer already fired or was cancelled
+	bool cancel(const TimerHandle handle) {
+		if (handle.index >= nodes.size() || nodes.at(handle.index).generation != handle.generation || !nodes.at(handle.index).active) {
+			return false;
+		}
+
+		unlink(handle.index);
+		release(handle.index);
+		return true;
+	}
+
+	void clear() {
+		for (uint32_t index = 0; index < nodes.size(); ++index) {
+			if (nodes.at(index).active) {
+				unlink(index);
+				release(index);
+			}
+		}
+	}
+
+	// Clears the timers and starts the clock over from tick 0
+	void reset() {
+		clear();
+		nextTick = 1;
+	}
+
+	// Fires, in tick order, every timer expiring up to and including the given tick
+	template<typename Callback>
+	void advance(const uint64_t tick, Callback&& callback) {
+		while (nextTick <= tick) {
+			const int index = int(nextTick & slotMask);
+
+			// Every time the finest level wraps around, the next slot of the coarser levels is spread over the finer ones
+			if (index == 0) {
+				for (int level = 1; level < levels; ++level) {
+					const int slot = int((nextTick >> (slotBits * level)) & slotMask);
+					cascade(level, slot);
+					if (slot != 0) {
+						break;
+					}
+				}
+			}
+
+			++nextTick;
+
+			uint32_t& head = slots.at(index);
+			while (head != none) {
+				const uint32_t node_index = head;
+				unlink(node_index);
+				const Payload payload = nodes.at(node_index).payload;
+				release(node_index);
+				callback(payload);
+			}
+		}
+	}
+
+private:
+	static constexpr uint32_t none = UINT32_MAX;
+	static constexpr uint64_t slotMask = slotsPerLevel - 1;
+
+	struct Node {
+		uint64_t expiry = 0;
+		Payload payload{};
+		uint32_t previous = none;
+		uint32_t next = none;
+		uint32_t slot = none;
+		uint32_t generation = 0;
+		bool active = false;
+	};
+
+	std::vector<Node> nodes;
+	std::array<uint32_t, slotsPerLevel * levels> slots;
+	uint32_t freeHead = none;
+	uint64_t nextTick = 1;
+
+	void insert(const uint32_t index) {
+		Node& node = nodes.at(index);
+		uint64_t expiry = node.expiry;
+		uint32_t slot;
+
+		if (expiry < nextTick) {
+			slot = uint32_t(nextTick & slotMask);
+		}
+		else {
+			uint64_t delay = expiry - nextTick;
+			if (delay > maxDelay) {
+				delay = maxDelay;
+				expiry = nextTick + delay;
+			}
+
+			int level = 0;
+			while (level + 1 < levels && delay >= (uint64_t(1) << (slotBits * (level + 1)))) {
+				++level;
+			}
+
+			slot = uint32_t(level * slotsPerLevel + ((expiry >> (slotBits * level)) & slotMask));
+		}
+
+		node.slot = slot;
+		node.previous = none;
+		node.next = slots.at(slot);
+		if (node.next != none) {
+			nodes.at(node.next).previous = index;
+		}
+		slots.at(slot) = index;
+	}
+
+	void unlink(const uint32_t index) {
+		Node& node = nodes.at(index);
+		if (node.previous != none) {
+			nodes.at(node.previous).next = node.next;
+		}
+		else {
+			slots.at(node.slot) = node.next;
+		}
+
+		if (node.next != none) {
+			nodes.at(node.next).previous = node.previous;
+		}
+
+		node.previous = none;
+		node.next = none;
+		node.slot = none;
+	}
+
+	void release(const uint32_t index) {
+		Node& node = nodes.at(index);
+		node.active = false;
+		++node.generation;
+		node.next = freeHead;
+		freeHead = index;
+	}
+
+	void cascade(const int level, const int slot) {
+		uint32_t& head = slots.at(level * slotsPerLevel + slot);
+		while (head != none) {
+			const uint32_t index = head;
+			unlink(index);
+			insert(index);
+		}
+	}
+};
@@ -0,0 +1,133 @@
+#include <memory.h>
+#include <raylib.h>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include "settings.h"
+#include "content.h"
+#include "level.h"
+#include "session.h"
+#include "spectator.h"
+
+// Watches a session hosted by another process, destructive_drones_server --spectate for example, through the shared
+// memory region it publishes every tick: destructive_drones_viewer [session id]
+// The published state is copied into a local session that only renders, with the game's own renderScene and renderUi.
+
+#if DD_SHARED_MEMORY
+// Puts the state of the last frame into the local session
+static void mirror(const Spectator::Reader& reader, Session& session) {
+	Level& level = session.level;
+	for (int y = 0; y < level.height; ++y) {
+		Level::Tile* row = level.row(y);
+		const uint8_t* states = reader.tiles.data() + size_t(y) * level.width;
+		for (int x = 0; x < level.width; ++x) {
+			const Level::Tile tile{ states[x] == Spectator::Bedrock, states[x] != Spectator::Empty ? session.settings.tileHealth : 0.0f };
+			if (tile.bedrock != row[x].bedrock || tile.solidity != row[x].solidity) {
+				row[x] = tile;
+				level.textureDirty = true;
+			}
+		}
+	}
+
+	const Spectator::Frame& frame = reader.frame;
+
+	session.players.clear();
+	for (int i = 0; i < frame.playerCount; ++i) {
+		const Spectator::PlayerState& state = frame.players[i];
+		Player player(Bounds{ glm::ivec2(state.x, state.y), glm::ivec2(4,4) }, std::clamp(int(state.playerIndex), 0, Settings::maxPlayers - 1), Controller::Remote, state.health);
+		player.previousPosition = glm::ivec2(state.previousX, state.previousY);
+		player.score = state.score;
+		player.ammo = state.ammo;
+		if (state.weapon >= 0 && state.weapon < weaponTypeCount) {
+			player.weapon = WeaponType(state.weapon);
+		}
+		session.players.emplace_back(std::move(player));
+	}
+
+	session.items.clear();
+	for (int i = 0; i < frame.itemCount; ++i) {
+		const Spectator::ItemState& state = frame.items[i];
+		session.items.emplace_back(Item(Bounds{ glm::ivec2(state.x, state.y), glm::ivec2(4,4) }, ItemType(state.type)));
+	}
+
+	for (PooledList<Projectile>& bucket : session.projectiles) {
+		bucket.clear();
+	}
+	for (int i = 0; i < frame.projectileCount; ++i) {
+		const Spectator::ProjectileState& state = frame.projectiles[i];
+		const int weapon = std::clamp(int(state.weapon), 0, weaponTypeCount - 1);
+		Projectile projectile(Bounds{ glm::ivec2(state.x, state.y), glm::ivec2(1,1) }, state.owner, weapon, glm::vec2(0, 0));
+		projectile.previousPosition = glm::ivec2(state.previousX, state.previousY);
+		session.projectiles.at(weapon).emplace_back(std::move(projectile));
+	}
+
+	// The frames are already whole ticks, drawn where the last one left them
+	session.time = frame.time;
+	session.tickAccumulator = 1.0 / session.settings.tickRate;
+}
+#endif
+
+int main(int argc, char** argv) {
+#if DD_SHARED_MEMORY
+	const uint32_t session_id = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 0;
+
+	InitWindow(720, 720, "Destructive Drones - Spectator");
+	SetWindowState(FLAG_WINDOW_RESIZABLE);
+	SetTargetFPS(std::max(GetMonitorRefreshRate(GetCurrentMonitor()), 60));
+
+	{
+		const Settings settings;
+		const Content content;
+		Camera2D camera;
+		memset(&camera, 0, sizeof(Camera2D));
+
+		Spectator::Reader reader;
+		std::unique_ptr<Level> level;
+		std::unique_ptr<Session> session;
+		double last_attach = -1;
+
+		while (!WindowShouldClose()) {
+			if (reader.isClosed() && GetTime() - last_attach > 1.0) {
+				session.reset();
+				last_attach = GetTime();
+				if (reader.attach(session_id)) {
+					level.reset(new Level(settings, reader.width, reader.height));
+					session.reset(new Session(settings, *level));
+				}
+			}
+
+			if (session && reader.read()) {
+				mirror(reader, *session);
+			}
+
+			{
+				const float pixels_per_unit = float(std::min(GetScreenWidth(), GetScreenHeight())) / 64.0f;
+				camera.zoom = pixels_per_unit;
+				camera.offset.x = (float(GetScreenWidth()) - pixels_per_unit * 64.0f) / 2.0f;
+				camera.offset.y = (float(GetScreenHeight()) - pixels_per_unit * 64.0f) / 2.0f;
+			}
+
+			BeginDrawing();
+			ClearBackground(BLACK);
+
+			if (session) {
+				BeginMode2D(camera);
+				session->renderScene(content);
+				session->renderUi(content);
+				EndMode2D();
+			}
+			else {
+				DrawText(TextFormat("Waiting for session %u", session_id), 10, 10, 20, GRAY);
+			}
+
+			EndDrawing();
+		}
+	}
+
+	CloseWindow();
+	return 0;
+#else
+	printf("Spectating needs POSIX shared memory, which this platform doesn't have\n");
+	return 1;
+#endif
+}
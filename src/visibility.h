@@ -0,0 +1,275 @@
+#pragma once
+
+#include <raylib.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "bit_grid.h"
+#include "level.h"
+#include "profiler.h"
+#include "settings.h"
+
+// Fog of war: the tiles each player sees from the center of its drone, one bit per tile. Views are computed with
+// symmetric recursive shadowcasting, which goes through the rows of a quadrant and splits the view around the walls.
+// The rows are walked a run of walls or floors at a time, found with bit scans, and lit a word at a time. The east and
+// west quadrants go through the columns as the rows of transposed grids.
+// A view is only recomputed when the player moves to another tile, or when a tile it sees is destroyed, since the
+// destroyed tiles that it doesn't see can't change what it sees.
+class Visibility {
+public:
+	static constexpr unsigned char fogAlpha = 224; // Hidden tiles are darkened, not removed, the layout is no secret
+
+	int width = 0;
+	int height = 0;
+
+	Visibility(const Level& level) : opaque(0, 0, true), opaqueColumns(0, 0, true), columnScratch(0, 0, false) {
+		reset(level);
+	}
+
+	Visibility(const Visibility&) = delete;
+	Visibility& operator=(const Visibility&) = delete;
+
+	~Visibility() {
+		if (fogTexture.id != 0) {
+			UnloadTexture(fogTexture);
+		}
+	}
+
+	// Takes the walls of the level, and drops every view
+	void reset(const Level& level) {
+		if (level.width != width || level.height != height) {
+			width = level.width;
+			height = level.height;
+			opaque = BitGrid(width, height, true);
+			opaqueColumns = BitGrid(height, width, true);
+			columnScratch = BitGrid(height, width, false);
+			views.assign(Settings::maxPlayers, BitGrid(width, height, false));
+
+			if (fogTexture.id != 0) {
+				UnloadTexture(fogTexture);
+				fogTexture = Texture{};
+			}
+			fogPixels.resize(size_t(width) * height);
+		}
+
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				const bool solid = level.tile(x, y).solidity > 0;
+				opaque.set(x, y, solid);
+				opaqueColumns.set(y, x, solid);
+			}
+		}
+
+		for (BitGrid& view : views) {
+			std::fill(view.bits.begin(), view.bits.end(), 0);
+		}
+		origins.fill(glm::ivec2(-1, -1));
+		dirty.fill(true);
+		stale = false;
+		++revision;
+	}
+
+	// The walls are out of date, for when the tiles destroyed weren't given to destroyTiles
+	void invalidate() {
+		stale = true;
+	}
+
+	// Takes the tiles destroyed since the last call, destroyed_tiles[first, end)
+	void destroyTiles(const Level& level, const std::vector<glm::ivec2>& destroyed_tiles, const size_t first) {
+		if (stale) {
+			reset(level);
+			return;
+		}
+
+		for (size_t i = first; i < destroyed_tiles.size(); ++i) {
+			const glm::ivec2 tile = destroyed_tiles[i];
+			opaque.set(tile.x, tile.y, false);
+			opaqueColumns.set(tile.y, tile.x, false);
+
+			for (int player = 0; player < Settings::maxPlayers; ++player) {
+				dirty[player] = dirty[player] || views[player].get(tile.x, tile.y);
+			}
+		}
+	}
+
+	// Recomputes the view of the player if it's out of date. Returns true if it did.
+	bool update(const int player, const glm::ivec2& origin) {
+		if (!dirty.at(player) && origins.at(player) == origin) {
+			return false;
+		}
+
+		PROFILE_SCOPE("Visibility::update");
+
+		BitGrid& view = views.at(player);
+		std::fill(view.bits.begin(), view.bits.end(), 0);
+		origins.at(player) = origin;
+		dirty.at(player) = false;
+		++revision;
+
+		if (origin.x < 0 || origin.y < 0 || origin.x >= width || origin.y >= height) {
+			return true;
+		}
+
+		view.set(origin.x, origin.y, true);
+		scan(opaque, view, origin.y, origin.x, -1, 1, Slope{ -1, 1 }, Slope{ 1, 1 });
+		scan(opaque, view, origin.y, origin.x, 1, 1, Slope{ -1, 1 }, Slope{ 1, 1 });
+
+		std::fill(columnScratch.bits.begin(), columnScratch.bits.end(), 0);
+		scan(opaqueColumns, columnScratch, origin.x, origin.y, -1, 1, Slope{ -1, 1 }, Slope{ 1, 1 });
+		scan(opaqueColumns, columnScratch, origin.x, origin.y, 1, 1, Slope{ -1, 1 }, Slope{ 1, 1 });
+
+		// Only the lit tiles of the columns are visited
+		for (int x = 0; x < width; ++x) {
+			for (int y = columnScratch.find(x, 0, height - 1, true); y < height; y = columnScratch.find(x, y + 1, height - 1, true)) {
+				view.set(x, y, true);
+			}
+		}
+
+		return true;
+	}
+
+	bool visible(const int player, const glm::ivec2& tile) const {
+		return views.at(player).get(tile.x, tile.y);
+	}
+
+	// Seen by any of the players in the mask, one bit per player index
+	bool visibleToAny(const uint32_t viewers, const glm::ivec2& tile) const {
+		for (int player = 0; player < Settings::maxPlayers; ++player) {
+			if (((viewers >> player) & 1) && views[player].get(tile.x, tile.y)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	const BitGrid& view(const int player) const {
+		return views.at(player);
+	}
+
+	// Darkens what none of the viewers see, the texture is only updated when the views change
+	void drawFog(const uint32_t viewers) {
+		if (fogTexture.id == 0) {
+			Image dummy_image = GenImageColor(width, height, BLANK);
+			fogTexture = LoadTextureFromImage(dummy_image);
+			UnloadImage(dummy_image);
+			fogRevision = revision - 1;
+		}
+
+		if (viewers != fogViewers || revision != fogRevision) {
+			for (int y = 0; y < height; ++y) {
+				for (int x_word = 0; x_word < opaque.words; ++x_word) {
+					uint64_t seen = 0;
+					for (int player = 0; player < Settings::maxPlayers; ++player) {
+						if ((viewers >> player) & 1) {
+							seen |= views[player].word(x_word, y);
+						}
+					}
+
+					const int x_end = std::min(width, (x_word + 1) * 64);
+					for (int x = x_word * 64; x < x_end; ++x) {
+						const bool lit = (seen >> (x % 64)) & 1;
+						fogPixels[size_t(y) * width + x] = glm::u8vec4(0, 0, 0, lit ? 0 : fogAlpha);
+					}
+				}
+			}
+
+			UpdateTexture(fogTexture, fogPixels.data());
+			fogViewers = viewers;
+			fogRevision = revision;
+		}
+
+		DrawTexture(fogTexture, 0, 0, WHITE);
+	}
+
+private:
+	// Slope of a line from the center of the origin, num / den with den > 0
+	struct Slope {
+		int num;
+		int den;
+	};
+
+	BitGrid opaque; // Solid tiles
+	BitGrid opaqueColumns; // Transposed, x is the row
+	BitGrid columnScratch; // East and west quadrants of the view being computed, transposed
+	std::vector<BitGrid> views;
+	std::array<glm::ivec2, Settings::maxPlayers> origins;
+	std::array<bool, Settings::maxPlayers> dirty;
+	bool stale = false;
+	uint64_t revision = 0; // Changes with any view
+
+	Texture fogTexture{};
+	Level::Pixels fogPixels;
+	uint32_t fogViewers = 0;
+	uint64_t fogRevision = 0;
+
+	static int floorDivide(const int num, const int den) {
+		return num / den - (num % den != 0 && num < 0 ? 1 : 0);
+	}
+
+	static int ceilDivide(const int num, const int den) {
+		return -floorDivide(-num, den);
+	}
+
+	// Edge of the tile at the column, on the side of the origin's column, from a row at the depth
+	static Slope tileSlope(const int column, const int depth) {
+		return Slope{ 2 * column - 1, 2 * depth };
+	}
+
+	// Lights the quadrant on one side of the origin line, from the row at the depth and between the slopes. The rows of
+	// the grid are the lines of the quadrant, going away from the origin in the direction, and the bits are the columns.
+	// Rows are scanned until they are closed by a wall, each run of floor closed by a wall on the far side is scanned
+	// on its own, deeper.
+	static void scan(const BitGrid& walls, BitGrid& lit, const int origin_line, const int origin_column, const int direction,
+		int depth, Slope start, const Slope end) {
+		while (true) {
+			const int line = origin_line + direction * depth;
+			if (line < 0 || line >= walls.height) {
+				return;
+			}
+
+			// Tiles whose center is between the slopes, rounded towards the middle of the quadrant
+			const int column_min = std::max(origin_column + floorDivide(2 * depth * start.num + start.den, 2 * start.den), 0);
+			const int column_max = std::min(origin_column + ceilDivide(2 * depth * end.num - end.den, 2 * end.den), walls.width - 1);
+			if (column_min > column_max) {
+				return;
+			}
+
+			// Walls are lit whenever they are reached, floors only within the slopes, so that seeing is symmetric
+			const int floor_min = origin_column + ceilDivide(depth * start.num, start.den);
+			const int floor_max = origin_column + floorDivide(depth * end.num, end.den);
+
+			bool wall = false;
+			for (int column = column_min; column <= column_max;) {
+				wall = walls.get(column, line);
+				const int run_end = walls.find(line, column, column_max, !wall);
+
+				if (wall) {
+					lit.setSpan(line, column, run_end - 1);
+					if (column > column_min) {
+						scan(walls, lit, origin_line, origin_column, direction, depth + 1, start, tileSlope(column - origin_column, depth));
+					}
+				}
+				else {
+					const int floor_start = std::max(column, floor_min);
+					const int floor_end = std::min(run_end - 1, floor_max);
+					if (floor_start <= floor_end) {
+						lit.setSpan(line, floor_start, floor_end);
+					}
+					if (column > column_min) {
+						start = tileSlope(column - origin_column, depth);
+					}
+				}
+
+				column = run_end;
+			}
+
+			if (wall) {
+				return;
+			}
+
+			++depth;
+		}
+	}
+};
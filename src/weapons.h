@@ -0,0 +1,48 @@
+#pragma once
+
+#include "settings.h"
+
+static constexpr int weaponTypeCount = 3;
+
+// Compile time behavior of each weapon, the session instantiates its projectile kernels from these.
+// The numbers (damage, speed, spread angle, life, blast radius...) still come from WeaponSettings. A trait makes its
+// behavior unconditional for the weapon, without one it's still enabled at run time by a setting that asks for it, see
+// hasSpread, hasExpiry and hasBlast: a blast radius given to the machine gun makes it explode.
+template<WeaponType Type>
+struct WeaponTraits;
+
+template<>
+struct WeaponTraits<WeaponType::MachineGun> {
+	static constexpr bool spread = false;	// Fires projectileCount projectiles over projectileSpread degrees
+	static constexpr bool expires = false;	// Projectiles disappear after projectileLife seconds
+	static constexpr bool blast = false;	// Hits damage everything within blastRadius
+};
+
+template<>
+struct WeaponTraits<WeaponType::Shotgun> {
+	static constexpr bool spread = true;
+	static constexpr bool expires = true;
+	static constexpr bool blast = false;
+};
+
+template<>
+struct WeaponTraits<WeaponType::RocketLauncher> {
+	static constexpr bool spread = false;
+	static constexpr bool expires = false;
+	static constexpr bool blast = true;
+};
+
+template<WeaponType Type>
+bool hasSpread(const WeaponSettings& weapon_settings) {
+	return WeaponTraits<Type>::spread || weapon_settings.projectileCount > 1;
+}
+
+template<WeaponType Type>
+bool hasExpiry(const WeaponSettings& weapon_settings) {
+	return WeaponTraits<Type>::expires || weapon_settings.projectileLife < FLT_MAX;
+}
+
+template<WeaponType Type>
+bool hasBlast(const WeaponSettings& weapon_settings) {
+	return WeaponTraits<Type>::blast || weapon_settings.blastRadius > 0;
+}